@@ -0,0 +1,11 @@
+// unity build batch 16
+#include "time.das.cpp"
+#include "toarray.das.cpp"
+#include "totable.das.cpp"
+#include "trailing_delimiters.das.cpp"
+#include "try-catch.das.cpp"
+#include "tuple.das.cpp"
+#include "typeAlias.das.cpp"
+#include "typeinfo.das.cpp"
+#include "typename.das.cpp"
+#include "types.das.cpp"
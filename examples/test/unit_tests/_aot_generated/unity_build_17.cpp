@@ -0,0 +1,9 @@
+// unity build batch 17
+#include "unused_arguments.das.cpp"
+#include "utf8.das.cpp"
+#include "variant.das.cpp"
+#include "variant_align.das.cpp"
+#include "vec_ctors.das.cpp"
+#include "vec_index.das.cpp"
+#include "vec_swizzle.das.cpp"
+#include "with.das.cpp"
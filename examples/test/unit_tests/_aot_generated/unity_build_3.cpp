@@ -0,0 +1,11 @@
+// unity build batch 3
+#include "bin_serializer.das.cpp"
+#include "bitfields.das.cpp"
+#include "block.das.cpp"
+#include "block_access_function_arg.das.cpp"
+#include "block_args_nested.das.cpp"
+#include "block_variable.das.cpp"
+#include "block_vs_local_block.das.cpp"
+#include "capture_as_ref.das.cpp"
+#include "cast.das.cpp"
+#include "check_defer.das.cpp"
@@ -0,0 +1,11 @@
+// unity build batch 4
+#include "check_eid.das.cpp"
+#include "check_type_info_macro.das.cpp"
+#include "clone.das.cpp"
+#include "clone_temp.das.cpp"
+#include "clone_to_move.das.cpp"
+#include "copy_and_move_on_return.das.cpp"
+#include "counter.das.cpp"
+#include "cpp_layout.das.cpp"
+#include "ctor.das.cpp"
+#include "das_string.das.cpp"
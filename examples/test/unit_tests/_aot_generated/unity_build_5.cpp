@@ -0,0 +1,11 @@
+// unity build batch 5
+#include "deref_ptr_fun.das.cpp"
+#include "dim.das.cpp"
+#include "div_by_zero.das.cpp"
+#include "dummy.das.cpp"
+#include "dynamic_array.das.cpp"
+#include "each_std_vector.das.cpp"
+#include "enum.das.cpp"
+#include "enum_total_test.das.cpp"
+#include "fast_to_int.das.cpp"
+#include "fastcall_crash.das.cpp"
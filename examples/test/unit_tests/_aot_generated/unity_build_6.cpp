@@ -0,0 +1,11 @@
+// unity build batch 6
+#include "finalizer_in_module.das.cpp"
+#include "finally.das.cpp"
+#include "fio.das.cpp"
+#include "foo_bar.das.cpp"
+#include "for-loop.das.cpp"
+#include "for_array_with_1_element.das.cpp"
+#include "for_const_array.das.cpp"
+#include "for_continue.das.cpp"
+#include "fully_qualified_generic_name.das.cpp"
+#include "fun.das.cpp"
@@ -0,0 +1,11 @@
+// unity build batch 7
+#include "func_addr.das.cpp"
+#include "generators.das.cpp"
+#include "global.das.cpp"
+#include "global_func_shadow_check.das.cpp"
+#include "global_order.das.cpp"
+#include "handle.das.cpp"
+#include "hint_macros_example.das.cpp"
+#include "ifnn.das.cpp"
+#include "ignore_deref.das.cpp"
+#include "include.das.cpp"
@@ -0,0 +1,11 @@
+// unity build batch 8
+#include "infer_alias_and_alias_ctor.das.cpp"
+#include "infer_alias_argument.das.cpp"
+#include "infer_remove_ref_const.das.cpp"
+#include "init_script.das.cpp"
+#include "inscope_return_inscope.das.cpp"
+#include "int2_crash.das.cpp"
+#include "int_types.das.cpp"
+#include "invoke_cmres.das.cpp"
+#include "join.das.cpp"
+#include "label.das.cpp"
@@ -0,0 +1,11 @@
+// unity build batch 9
+#include "lambda.das.cpp"
+#include "lambda_capture_modes.das.cpp"
+#include "lambda_to_iter.das.cpp"
+#include "line_info.das.cpp"
+#include "local_reference.das.cpp"
+#include "lock_array.das.cpp"
+#include "lock_forever.das.cpp"
+#include "loop_ret.das.cpp"
+#include "make_default.das.cpp"
+#include "make_handle.das.cpp"
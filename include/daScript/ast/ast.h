@@ -617,6 +617,12 @@ namespace das
         virtual bool rtti_isOp1() const { return false; }
         virtual bool rtti_isOp2() const { return false; }
         virtual bool rtti_isOp3() const { return false; }
+        virtual bool rtti_isCopy() const { return false; }
+        virtual bool rtti_isMove() const { return false; }
+        virtual bool rtti_isClone() const { return false; }
+        virtual bool rtti_isNew() const { return false; }
+        virtual bool rtti_isDelete() const { return false; }
+        virtual bool rtti_isTryCatch() const { return false; }
         virtual bool rtti_isNullCoalescing() const { return false; }
         virtual bool rtti_isValues() const { return false; }
         virtual bool rtti_isMakeBlock() const { return false; }
@@ -901,6 +907,7 @@ namespace das
                 bool    captureString : 1;
                 bool    callCaptureString : 1;
                 bool    hasStringBuilder : 1;
+                bool    aotCold : 1;
             };
             uint32_t moreFlags = 0;
         };
@@ -1137,6 +1144,7 @@ namespace das
         CommentReaderPtr                            commentReader;      // /* blah */ or // blah
         vector<pair<string,bool>>                   keywords;           // keywords (and if they need oxford comma)
         das_hash_map<string,Type>                   options;            // options
+        vector<FileInfoPtr>                         inlinedFileInfo;    // sources of the functions, inlined into this module
         uint64_t                                    cumulativeHash = 0; // hash of all mangled names in this module (for builtin modules)
         string                                      name;
         string                                      fileName;           // where the module was found, if not built-in
@@ -1351,6 +1359,7 @@ namespace das
         bool        multiple_contexts = false;          // code supports context safety
         uint32_t    heap_size_hint = 65536;
         uint32_t    string_heap_size_hint = 65536;
+        uint32_t    heap_nursery_size = 0;              // if not 0, short lived allocations go to the bump-allocated nursery first
         bool        solid_context = false;              // all access to varable and function lookup to be context-dependent (via index)
                                                         // this is slightly faster, but prohibits AOT or patches
         bool        macro_context_persistent_heap = true;   // if true, then persistent heap is used for macro context
@@ -1397,6 +1406,9 @@ namespace das
         //      2. invoke of blocks will have extra prologue overhead
         //      3. context always has context mutex
         bool debugger = false;
+        //  when enabled with the debugger, release nodes are emitted
+        //      breakpoints and single step patch statement nodes at runtime, instead of SimNodeDebug_* checking every statement
+        bool debugger_patching = false;
         string debug_module;
     // profiler
         // only enabled if profiler is disabled
@@ -1465,6 +1477,8 @@ namespace das
         Module * addModule ( const string & name );
         void finalizeAnnotations();
         bool patchAnnotations();
+        bool elideLockChecks ( TextWriter & logs );
+        bool markNonEscapingArrays ( TextWriter & logs );
         void fixupAnnotations();
         void normalizeOptionTypes ();
         void inferTypes(TextWriter & logs, ModuleGroup & libGroup);
@@ -1473,6 +1487,8 @@ namespace das
         void lint (TextWriter & logs, ModuleGroup & libGroup );
         void checkSideEffects();
         void foldUnsafe();
+        bool optimizationDevirtualization ( TextWriter & logs );
+        bool optimizationInlining ( TextWriter & logs );
         bool optimizationRefFolding();
         bool optimizationConstFolding();
         bool optimizationBlockFolding();
@@ -1490,6 +1506,7 @@ namespace das
         void removeUnusedSymbols();
         void clearSymbolUse();
         void dumpSymbolUse(TextWriter & logs);
+        void markNonEscapingAllocations ( TextWriter & logs );
         void allocateStack(TextWriter & logs);
         void deriveAliases(TextWriter & logs);
         bool simulate ( Context & context, TextWriter & logs, StackAllocator * sharedStack = nullptr );
@@ -1511,11 +1528,14 @@ namespace das
         void writeStandaloneContextMethods ( TextWriter & logs );
         void registerAotCpp ( TextWriter & logs, Context & context, bool headers = true, bool allModules = false );
         void validateAotCpp ( TextWriter & logs, Context & context );
+        void markHotAot ( const AotProfile & profile, double coverage, int inlineSize, TextWriter & logs );
         void buildMNLookup ( Context & context, const vector<FunctionPtr> & lookupFunctions, TextWriter & logs );
         void buildGMNLookup ( Context & context, TextWriter & logs );
         void buildADLookup ( Context & context, TextWriter & logs );
         bool getOptimize() const;
         bool getDebugger() const;
+        bool getDebuggerPatching() const;
+        bool getDebugNodes() const;
         bool getProfiler() const;
         void makeMacroModule( TextWriter & logs );
         vector<ReaderMacroPtr> getReaderMacro ( const string & markup ) const;
@@ -1548,6 +1568,8 @@ namespace das
         int                         totalFunctions = 0;
         int                         totalVariables = 0;
         int                         newLambdaIndex = 1;
+        int                         totalStackAllocations = 0;  // 'new' moved to the stack frame by the escape analysis
+        int                         totalScopedArrays = 0;      // local arrays deleted at the end of scope by the escape analysis
         vector<Error>               errors;
         vector<Error>               aotErrors;
         uint32_t                    globalInitStackSize = 0;
@@ -113,6 +113,7 @@ namespace das
         ExprDelete() { __rtti = "ExprDelete"; }
         ExprDelete ( const LineInfo & a, const ExpressionPtr & s )
             : Expression(a), subexpr(s) { __rtti = "ExprDelete"; }
+        virtual bool rtti_isDelete() const override { return true; }
         virtual ExpressionPtr clone( const ExpressionPtr & expr = nullptr ) const override;
         virtual SimNode * simulate (Context & context) const override;
         virtual ExpressionPtr visit(Visitor & vis) override;
@@ -456,6 +457,7 @@ namespace das
         ExprCopy () { __rtti = "ExprCopy"; };
         ExprCopy ( const LineInfo & a, const ExpressionPtr & l, const ExpressionPtr & r )
             : ExprOp2(a, "=", l, r) { __rtti = "ExprCopy"; };
+        virtual bool rtti_isCopy() const override { return true; }
         virtual ExpressionPtr clone( const ExpressionPtr & expr = nullptr ) const override;
         virtual SimNode * simulate (Context & context) const override;
         virtual ExpressionPtr visit(Visitor & vis) override;
@@ -474,6 +476,7 @@ namespace das
         ExprMove () { __rtti = "ExprMove"; };
         ExprMove ( const LineInfo & a, const ExpressionPtr & l, const ExpressionPtr & r )
             : ExprOp2(a, "<-", l, r) { __rtti = "ExprMove"; };
+        virtual bool rtti_isMove() const override { return true; }
         virtual ExpressionPtr clone( const ExpressionPtr & expr = nullptr ) const override;
         virtual SimNode * simulate (Context & context) const override;
         virtual ExpressionPtr visit(Visitor & vis) override;
@@ -492,6 +495,7 @@ namespace das
         ExprClone () { __rtti = "ExprClone"; };
         ExprClone ( const LineInfo & a, const ExpressionPtr & l, const ExpressionPtr & r )
             : ExprOp2(a, ":=", l, r) { __rtti = "ExprClone"; };
+        virtual bool rtti_isClone() const override { return true; }
         virtual ExpressionPtr clone( const ExpressionPtr & expr = nullptr ) const override;
         virtual SimNode * simulate (Context & context) const override;
         virtual ExpressionPtr visit(Visitor & vis) override;
@@ -528,6 +532,7 @@ namespace das
         ExprTryCatch() { __rtti = "ExprTryCatch"; };
         ExprTryCatch ( const LineInfo & a, const ExpressionPtr & t, const ExpressionPtr & c )
             : Expression(a), try_block(t), catch_block(c) { __rtti = "ExprTryCatch"; }
+        virtual bool rtti_isTryCatch() const override { return true; }
         virtual SimNode * simulate (Context & context) const override;
         virtual ExpressionPtr visit(Visitor & vis) override;
         virtual ExpressionPtr clone( const ExpressionPtr & expr = nullptr ) const override;
@@ -1219,6 +1224,7 @@ namespace das
             struct {
                 bool    useStackRef : 1;
                 bool    needTypeInfo : 1;
+                bool    onStack : 1;        // does not escape, allocated in the stack frame
             };
             uint32_t    ascendFlags = 0;
         };
@@ -1249,12 +1255,14 @@ namespace das
         ExprNew() { __rtti = "ExprNew"; };
         ExprNew ( const LineInfo & a, TypeDeclPtr t, bool ini )
             : ExprCallFunc(a,"new"), typeexpr(t), initializer(ini) { __rtti = "ExprNew"; }
+        virtual bool rtti_isNew() const override { return true; }
         virtual ExpressionPtr clone( const ExpressionPtr & expr = nullptr ) const override;
         virtual SimNode * simulate (Context & context) const override;
         virtual ExpressionPtr visit(Visitor & vis) override;
         virtual void serialize( AstSerializer & ser ) override;
         TypeDeclPtr     typeexpr;
         bool            initializer = false;
+        bool            onStack = false;        // does not escape, allocated in the stack frame
     };
 
     struct ExprCall : ExprCallFunc {
@@ -84,6 +84,10 @@ using das_safe_set = std::set<K,C>;
   #define DAS_FUSION  0
 #endif
 
+#ifndef DAS_FUSION_PROFILE
+  #define DAS_FUSION_PROFILE  0
+#endif
+
 #ifndef DAS_DEBUGGER
   #define DAS_DEBUGGER  1
 #endif
@@ -337,6 +337,12 @@ inline size_t das_aligned_memsize(void * ptr){
 #define DAS_TRACK_ALLOCATIONS   0
 #endif
 
+// when enabled, SimNode::debugInfo is a reference into the side table in the Context::debugInfo
+// nodes are 16 bytes smaller, and line info is only touched on errors, stack walks, profiling and debugging
+#ifndef DAS_COMPACT_DEBUG_INFO
+#define DAS_COMPACT_DEBUG_INFO  0
+#endif
+
 // when enabled, Context heap memory will be filled with 0xcd when deleted
 #ifndef DAS_SANITIZER
 #define DAS_SANITIZER   0
@@ -83,6 +83,18 @@ namespace das {
     vec4f builtin_make_enum_iterator ( Context & context, SimNode_CallBase * call, vec4f * );
     void builtin_make_string_iterator ( Sequence & result, char * str, Context * context );
 
+    class CoroutineScheduler;
+    CoroutineScheduler * builtin_co_scheduler_create ( Context * context, LineInfoArg * at );
+    void builtin_co_scheduler_remove ( CoroutineScheduler * & sched, Context * context, LineInfoArg * at );
+    void builtin_with_co_scheduler ( const TBlock<void,CoroutineScheduler *> & blk, Context * context, LineInfoArg * at );
+    void builtin_co_scheduler_add ( CoroutineScheduler * sched, const Sequence & it, Context * context, LineInfoArg * at );
+    bool builtin_co_scheduler_tick ( CoroutineScheduler * sched, Context * context, LineInfoArg * at );
+    int32_t builtin_co_scheduler_signal ( CoroutineScheduler * sched, int32_t event, Context * context, LineInfoArg * at );
+    void builtin_co_scheduler_clear ( CoroutineScheduler * sched, Context * context, LineInfoArg * at );
+    bool builtin_co_transfer ( const Sequence & it );
+    bool builtin_co_wait ( int32_t event );
+    void builtin_co_resumed ();
+
     void resetProfiler( Context * context );
     void dumpProfileInfo( Context * context );
     char * collectProfileInfo( Context * context );
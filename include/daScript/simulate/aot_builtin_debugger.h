@@ -5,6 +5,7 @@ namespace das {
     DebugAgentPtr makeDebugAgent ( const void * pClass, const StructInfo * info, Context * context );
     void debuggerStackWalk ( Context & context, const LineInfo & lineInfo );
     void debuggerSetContextSingleStep ( Context & context, bool step );
+    bool debuggerIsSupported ();
 
     DataWalkerPtr makeDataWalker ( const void * pClass, const StructInfo * info, Context * context );
     void dapiWalkData ( DataWalkerPtr walker, void * data, const TypeInfo & info );
@@ -36,4 +37,15 @@ namespace das {
     bool clear_hw_breakpoint ( int32_t bpi );
 
     void break_on_free ( Context & ctx, void * ptr, uint32_t size );
+
+    void heap_sampler_enable ( Context & ctx, uint64_t sampleRate, int32_t maxDepth );
+    void heap_sampler_disable ( Context & ctx );
+    int32_t heap_sampler_snapshot ( Context & ctx, Context * context, LineInfoArg * at );
+    char * heap_sampler_report ( Context & ctx, int32_t topN, Context * context, LineInfoArg * at );
+    char * heap_sampler_diff ( Context & ctx, int32_t fromSnapshot, int32_t toSnapshot, int32_t topN, Context * context, LineInfoArg * at );
+    char * heap_sampler_pprof ( Context & ctx, int32_t snapshot, int32_t baseSnapshot, Context * context, LineInfoArg * at );
+
+    void reset_fusion_profile ( );
+    char * collect_fusion_profile ( Context & ctx, int32_t topN, Context * context, LineInfoArg * at );
+    char * generate_fusion_patterns ( Context & ctx, int32_t topN, Context * context, LineInfoArg * at );
 }
@@ -134,6 +134,16 @@ namespace das {
 
     void rtti_builtin_simulate ( const smart_ptr<Program> & program,
         const TBlock<void,bool,smart_ptr<Context>,string> & block, Context * context, LineInfoArg * lineinfo );
+    void rtti_fork_context ( Context & source, const TBlock<void,smart_ptr<Context>> & block, Context * context, LineInfoArg * at );
+    smart_ptr<ContextTenant> rtti_make_tenant ( const char * name, uint64_t limit, uint64_t softLimit );
+    smart_ptr<ContextTenant> rtti_make_sub_tenant ( const char * name, uint64_t limit, uint64_t softLimit, smart_ptr_raw<ContextTenant> parent );
+    void rtti_set_context_tenant ( Context & ctx, smart_ptr_raw<ContextTenant> tenant, Context * context, LineInfoArg * at );
+    void rtti_clear_context_tenant ( Context & ctx, Context * context, LineInfoArg * at );
+    smart_ptr<ContextTenant> rtti_get_context_tenant ( Context & ctx );
+    int32_t rtti_tenant_collect ( smart_ptr_raw<ContextTenant> tenant, Context * context, LineInfoArg * at );
+    void rtti_tenant_start_budget ( smart_ptr_raw<ContextTenant> tenant, uint64_t usec, Context * context, LineInfoArg * at );
+    bool rtti_tenant_check_budget ( smart_ptr_raw<ContextTenant> tenant, Context * context, LineInfoArg * at );
+    void rtti_tenant_stop ( smart_ptr_raw<ContextTenant> tenant, Context * context, LineInfoArg * at );
 
     void rtti_builtin_program_for_each_module(smart_ptr_raw<Program> prog, const TBlock<void, Module *> & block, Context * context, LineInfoArg * lineinfo);
     void rtti_builtin_program_for_each_registered_module(const TBlock<void, Module *> & block, Context * context, LineInfoArg * lineinfo);
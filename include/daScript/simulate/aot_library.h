@@ -20,6 +20,21 @@ namespace das {
     AotLibrary & getGlobalAotLibrary();
     void clearGlobalAotLibrary();
 
+    // semantic hashes of the functions, which profile guided AOT left interpreted
+    //  kept apart from the library, so that a cold entry never hides a factory of the same function compiled elsewhere
+    typedef das_hash_set<uint64_t> AotColdSet;
+    AotColdSet & getGlobalAotColdSet();
+
+    // profile guided AOT
+
+    struct AotProfileRecord {
+        uint64_t    calls = 0;
+        uint64_t    time = 0;       // exclusive time, in profiler units
+    };
+    typedef das_hash_map<uint64_t,AotProfileRecord> AotProfile;    // mangled name hash -> record
+
+    bool loadAotProfile ( const string & fileName, AotProfile & profile, TextWriter & logs );
+
     // Test standalone context
 
     typedef Context * ( * RegisterTestCreator ) ();
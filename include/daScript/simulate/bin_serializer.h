@@ -10,4 +10,12 @@ namespace das {
     // load ( obj, bytesAt:uint32 )
     vec4f _builtin_binary_load ( Context & context, SimNode_CallBase * call, vec4f * args );
     void _builtin_binary_load ( Context & context, TypeInfo* info, const char *data, uint32_t len, char *to);//
+
+    // flat_save ( obj, block<(bytesAt:array<uint8>)> )
+    vec4f _builtin_flat_save ( Context & context, SimNode_CallBase * call, vec4f * args );
+    // flat_save ( obj, file ) : uint64
+    vec4f _builtin_flat_save_file ( Context & context, SimNode_CallBase * call, vec4f * args );
+    // flat_view ( type<T>, bytesAt:array<uint8>, block<(obj:T)> )
+    vec4f _builtin_flat_view ( Context & context, SimNode_CallBase * call, vec4f * args );
+    char * flat_relocate ( Context & context, TypeInfo * info, Array & arr, LineInfo * at );
 }
@@ -98,6 +98,8 @@ namespace das
         string      cppName;
     };
 
+    struct LineInfo;
+
     struct FileInfo {
     public:
         virtual void freeSourceData() { }
@@ -105,6 +107,9 @@ namespace das
         void reserveProfileData();
         virtual void getSourceAndLength ( const char * & src, uint32_t & len ) { src=nullptr; len=0; }
         virtual void serialize ( AstSerializer & ser );
+        // call site and name of the function, when this is the source of the inlined one
+        virtual const LineInfo * getInlinedAt() const { return nullptr; }
+        virtual const char * getInlinedFunction() const { return nullptr; }
         string                name;
         int32_t               tabSize = 4;
 #if DAS_ENABLE_PROFILER
@@ -203,6 +208,7 @@ namespace das
         bool inside ( const LineInfo & info ) const;
         bool empty() const;
         string describe(bool fully = false) const;
+        string describeInlined() const;
         FileInfo *  fileInfo = nullptr;
         uint32_t    column = 0, line = 0;
         uint32_t    last_column = 0, last_line = 0;
@@ -211,6 +217,23 @@ namespace das
 
     struct LineInfoArg : LineInfo {};
 
+    // source of the inlined function, as seen from one of its call sites
+    //  expressions of the inlined body point here, so that the error in them reports both the line in the callee and the call
+    //  when the caller was inlined as well, file info of the call site is inlined too, which makes the chain
+    class InlinedFileInfo : public FileInfo {
+    public:
+        InlinedFileInfo ( ) = default;
+        InlinedFileInfo ( FileInfo * src, const string & fn, const LineInfo & at );
+        virtual void getSourceAndLength ( const char * & src, uint32_t & len ) override;
+        virtual void serialize ( AstSerializer & ser ) override;
+        virtual const LineInfo * getInlinedAt() const override { return &inlinedAt; }
+        virtual const char * getInlinedFunction() const override { return function.c_str(); }
+    public:
+        FileInfo *  source = nullptr;
+        string      function;
+        LineInfo    inlinedAt;
+    };
+
     struct TypeInfo {
         enum {
             flag_ref = 1<<0,
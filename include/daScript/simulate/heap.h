@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "daScript/misc/memory_model.h"
 #include "daScript/misc/callable.h"
 #include "daScript/misc/anyhash.h"
@@ -124,8 +126,57 @@ namespace das {
         uint32_t    stackSize = 0;
     };
 
+    class NurseryHeapAllocator;
+    class Context;
+
+    // memory and time accounting, shared by a group of contexts (main context and its clones)
+    //  tenants form a hierarchy, an allocation fails if it takes any tenant up the chain over its limit
+    //  time budget is enforced by setting EvalFlags::stopForBudget on the contexts of the tenant, see checkBudget
+    class ContextTenant : public ptr_ref_count {
+    public:
+        ContextTenant ( const string & n, uint64_t lim = 0, uint64_t soft = 0, const smart_ptr<ContextTenant> & p = nullptr );
+        virtual ~ContextTenant();
+        bool charge ( int64_t size, bool enforce = true );  // negative size gives bytes back, and never fails
+        ContextTenant * overLimit ( int64_t size ) const;   // tenant, which limit stops the allocation
+        void addContext ( Context * ctx );
+        void removeContext ( Context * ctx );
+        int32_t collectIdle ( Context * except );   // collects heaps of contexts, which are not running right now
+        void startBudget ( uint64_t usec );     // starts new time slice, and clears pending stops
+        bool checkBudget();                     // stops contexts of the tenant, if the time slice is over
+        void stop();
+        __forceinline uint64_t getLimit() const { return limit; }
+        __forceinline uint64_t getSoftLimit() const { return softLimit; }
+        __forceinline uint64_t getTimeBudgetUsec() const { return timeBudgetUsec; }
+        __forceinline int64_t getBytes() const { return bytes; }
+        __forceinline int64_t getPeakBytes() const { return peakBytes; }
+        __forceinline uint64_t getAllocations() const { return allocations; }
+        __forceinline uint64_t getFailedAllocations() const { return failedAllocations; }
+        __forceinline uint64_t getSoftLimitHits() const { return softLimitHits; }
+        __forceinline uint64_t getCollections() const { return collections; }
+        __forceinline uint64_t getBudgetStops() const { return budgetStops; }
+    public:
+        string                      name;
+        smart_ptr<ContextTenant>    parent;
+        uint64_t                    limit = 0;
+        uint64_t                    softLimit = 0;
+        atomic<uint64_t>            timeBudgetUsec{0};   // budget is started and checked from any thread
+        atomic<int64_t>             budgetStart{0};
+        function<void(ContextTenant *)> onSoftLimit;   // called on the allocating thread, when bytes go over the soft limit
+        atomic<int64_t>             bytes{0};
+        atomic<int64_t>             peakBytes{0};
+        atomic<uint64_t>            allocations{0};
+        atomic<uint64_t>            failedAllocations{0};
+        atomic<uint64_t>            softLimitHits{0};
+        atomic<uint64_t>            collections{0};
+        atomic<uint64_t>            budgetStops{0};
+    protected:
+        mutex                       contextsLock;
+        vector<Context *>           contexts;   // of this tenant, and of all the tenants below
+    };
+
     class AnyHeapAllocator : public ptr_ref_count {
     public:
+        virtual NurseryHeapAllocator * asNursery() { return nullptr; }
         virtual bool breakOnFree ( void *, uint32_t ) { return false; }
         virtual char * impl_allocate ( uint32_t ) = 0;
         virtual void impl_free ( char *, uint32_t ) = 0;
@@ -148,6 +199,16 @@ namespace das {
         __forceinline uint64_t getTotalAllocations() const { return totalAllocations; }
         __forceinline uint64_t getTotalBytesAllocated() const { return totalBytesAllocated; }
         __forceinline uint64_t getTotalBytesDeleted() const { return totalBytesDeleted; }
+        __forceinline ContextTenant * getTenant() const { return tenant; }
+        void setTenant ( ContextTenant * t );
+        void syncTenant();  // after collection or reset, charges whatever changed without going through free
+    protected:
+        __forceinline bool tenantCharge ( int64_t size ) {
+            if ( !tenant ) return true;
+            if ( !tenant->charge(size) ) return false;
+            tenantBytes += size;
+            return true;
+        }
     public:
 #if DAS_TRACK_ALLOCATIONS
         virtual void mark_location ( void *, const LineInfo * )  {}
@@ -165,6 +226,8 @@ namespace das {
         uint64_t totalAllocations = 0;
         uint64_t totalBytesAllocated = 0;
         uint64_t totalBytesDeleted = 0;
+        ContextTenant * tenant = nullptr;
+        int64_t tenantBytes = 0;
     };
 
     struct StrHashEntry {
@@ -239,6 +302,7 @@ namespace das {
     public:
         virtual void impl_free ( char * ptr, uint32_t size ) override {
             totalBytesDeleted += size;
+            tenantCharge(-int64_t(size));
             model.free(ptr,size);
         }
         virtual void sweep() override { model.sweep(); }
@@ -246,7 +310,7 @@ namespace das {
     public:
         PersistentHeapAllocator() {}
         virtual char * impl_allocate ( uint32_t size ) override {
-            if ( limit==0 || model.bytesAllocated()+size<=limit ) {
+            if ( (limit==0 || model.bytesAllocated()+size<=limit) && tenantCharge(size) ) {
                 totalAllocations ++;
                 totalBytesAllocated += size;
                 return model.allocate(size);
@@ -255,7 +319,7 @@ namespace das {
             }
         }
         virtual char * impl_reallocate ( char * ptr, uint32_t oldSize, uint32_t newSize ) override {
-            if ( limit==0 || model.bytesAllocated()+newSize-oldSize<=limit ) {
+            if ( (limit==0 || model.bytesAllocated()+newSize-oldSize<=limit) && tenantCharge(int64_t(newSize)-int64_t(oldSize)) ) {
                 totalAllocations ++;
                 totalBytesAllocated += newSize-oldSize;
                 return model.reallocate(ptr,oldSize,newSize);
@@ -287,7 +351,7 @@ namespace das {
     public:
         LinearHeapAllocator() {}
         virtual char * impl_allocate ( uint32_t size ) override {
-            if ( limit==0 || model.bytesAllocated()+size<=limit ) {
+            if ( (limit==0 || model.bytesAllocated()+size<=limit) && tenantCharge(size) ) {
                 totalAllocations ++;
                 totalBytesAllocated += size;
                 return model.allocate(size);
@@ -297,10 +361,11 @@ namespace das {
         }
         virtual void impl_free ( char * ptr, uint32_t size ) override {
             totalBytesDeleted += size;
+            tenantCharge(-int64_t(size));
             model.free(ptr,size);
         }
         virtual char * impl_reallocate ( char * ptr, uint32_t oldSize, uint32_t newSize ) override {
-            if ( limit==0 || model.bytesAllocated()+newSize-oldSize<=limit ) {
+            if ( (limit==0 || model.bytesAllocated()+newSize-oldSize<=limit) && tenantCharge(int64_t(newSize)-int64_t(oldSize)) ) {
                 totalAllocations ++;
                 totalBytesAllocated += newSize-oldSize;
                 return model.reallocate(ptr,oldSize,newSize);
@@ -325,6 +390,68 @@ namespace das {
         LinearChunkAllocator model;
     };
 
+    // bump-pointer young region in front of the regular heap
+    //  allocations which fit go into the fixed size region, the rest go straight to the 'old' heap
+    //  freeing a young allocation only rewinds the region if it was the last one
+    //  Context::collectNursery copies everything reachable into the old heap and resets the region
+    class NurseryHeapAllocator final : public AnyHeapAllocator {
+    public:
+        NurseryHeapAllocator ( const smart_ptr<AnyHeapAllocator> & o, uint32_t size );
+        virtual ~NurseryHeapAllocator();
+        virtual NurseryHeapAllocator * asNursery() override { return this; }
+        virtual char * impl_allocate ( uint32_t size ) override;
+        virtual void impl_free ( char * ptr, uint32_t size ) override;
+        virtual char * impl_reallocate ( char * ptr, uint32_t oldSize, uint32_t newSize ) override;
+        virtual int depth() const override { return old->depth(); }
+        virtual uint64_t bytesAllocated() const override { return old->bytesAllocated() + youngBytes() + retiredBytes; }
+        virtual uint64_t totalAlignedMemoryAllocated() const override;
+        virtual void reset() override;
+        virtual void report() override;
+        virtual bool mark() override;
+        virtual bool mark ( char * ptr, uint32_t size ) override;
+        virtual void sweep() override;
+        virtual bool isOwnPtr ( char * ptr, uint32_t size ) override { return isYoung(ptr) || isRetired(ptr) || old->isOwnPtr(ptr,size); }
+        virtual bool isValidPtr ( char * ptr, uint32_t size ) override { return isYoung(ptr) || isRetired(ptr) || old->isValidPtr(ptr,size); }
+        virtual void setInitialSize ( uint32_t size ) override { old->setInitialSize(size); }
+        virtual int32_t getInitialSize() const override { return old->getInitialSize(); }
+        virtual void setGrowFunction ( CustomGrowFunction && fun ) override { old->setGrowFunction(das::move(fun)); };
+#if DAS_TRACK_ALLOCATIONS
+        virtual void mark_location ( void * ptr, const LineInfo * at ) override { if ( !isYoung((char *)ptr) ) old->mark_location(ptr,at); };
+        virtual  void mark_comment ( void * ptr, const char * what ) override { if ( !isYoung((char *)ptr) ) old->mark_comment(ptr,what); };
+#endif
+        __forceinline bool isYoung ( char * ptr ) const { return region<=ptr && ptr<region+top; }
+        __forceinline bool isRetired ( char * ptr ) const { return findRetired(ptr)>=0; }
+        int32_t findRetired ( char * ptr ) const;       // index of the retired region, which contains ptr
+        __forceinline uint32_t youngBytes() const { return top; }
+        __forceinline uint32_t youngAllocations() const { return uint32_t(offsets.size()); }
+        __forceinline uint32_t getRegionSize() const { return regionSize; }
+        __forceinline const smart_ptr<AnyHeapAllocator> & getOld() const { return old; }
+        int32_t findAllocation ( char * ptr ) const;    // index of the young allocation, which contains ptr
+        // copy live allocations to the old heap, patch the given locations, and reset the region
+        bool evacuate ( const vector<uint8_t> & live, const vector<char **> & fixups, const callable<void (char *, char *)> & moved );
+        // keep the region as is, and start a new one
+        void retire();
+    public:
+        uint64_t    minorCollections = 0;
+        uint64_t    bytesPromoted = 0;
+        uint64_t    bytesReclaimed = 0;
+        uint64_t    regionsRetired = 0;
+        uint64_t    regionsFreed = 0;
+        uint64_t    lastPauseUsec = 0;
+        uint64_t    maxPauseUsec = 0;
+    protected:
+        char * translate ( char * ptr, const vector<char *> & forward ) const;
+        smart_ptr<AnyHeapAllocator> old;
+        char *              region = nullptr;
+        uint32_t            regionSize = 0;
+        uint32_t            top = 0;
+        uint64_t            retiredBytes = 0;
+        vector<uint32_t>    offsets;
+        vector<uint32_t>    sizes;
+        vector<pair<char *,uint32_t>>   retired;        // sorted by address
+        das_hash_set<char *>            markedYoung;
+    };
+
 #if DAS_TRACK_ALLOCATIONS
     extern uint64_t    g_tracker_string;
     extern uint64_t    g_breakpoint_string;
@@ -348,7 +475,7 @@ namespace das {
     public:
         PersistentStringAllocator() { model.alignMask = 3; }
         virtual char * impl_allocate ( uint32_t size ) override {
-            if ( limit==0 || model.bytesAllocated()+size<=limit ) {
+            if ( (limit==0 || model.bytesAllocated()+size<=limit) && tenantCharge(size) ) {
                 totalAllocations ++;
                 totalBytesAllocated += size;
                 return model.allocate(size);
@@ -358,10 +485,11 @@ namespace das {
         }
         virtual void impl_free ( char * ptr, uint32_t size ) override {
             totalBytesDeleted += size;
+            tenantCharge(-int64_t(size));
             model.free(ptr,size);
         }
         virtual char * impl_reallocate ( char * ptr, uint32_t oldSize, uint32_t newSize ) override {
-            if ( limit==0 || model.bytesAllocated()+newSize-oldSize<=limit ) {
+            if ( (limit==0 || model.bytesAllocated()+newSize-oldSize<=limit) && tenantCharge(int64_t(newSize)-int64_t(oldSize)) ) {
                 totalAllocations ++;
                 totalBytesAllocated += newSize-oldSize;
                 return model.reallocate(ptr,oldSize,newSize);
@@ -395,7 +523,7 @@ namespace das {
     public:
         LinearStringAllocator() { model.alignMask = 3; }
         virtual char * impl_allocate ( uint32_t size ) override {
-            if ( limit==0 || model.bytesAllocated()+size<=limit ) {
+            if ( (limit==0 || model.bytesAllocated()+size<=limit) && tenantCharge(size) ) {
                 totalAllocations ++;
                 totalBytesAllocated += size;
                 return model.allocate(size);
@@ -405,10 +533,11 @@ namespace das {
         }
         virtual void impl_free ( char * ptr, uint32_t size ) override {
             totalBytesDeleted += size;
+            tenantCharge(-int64_t(size));
             model.free(ptr,size);
         }
         virtual char * impl_reallocate ( char * ptr, uint32_t oldSize, uint32_t newSize ) override {
-            if ( limit==0 || model.bytesAllocated()+newSize-oldSize<=limit ) {
+            if ( (limit==0 || model.bytesAllocated()+newSize-oldSize<=limit) && tenantCharge(int64_t(newSize)-int64_t(oldSize)) ) {
                 totalAllocations ++;
                 totalBytesAllocated += newSize-oldSize;
                 return model.reallocate(ptr,oldSize,newSize);
@@ -446,10 +575,43 @@ namespace das {
     };
     static_assert(sizeof(NodePrefix)==sizeof(vec4f), "node prefix must be one alignment line");
 
+#if DAS_COMPACT_DEBUG_INFO
+    struct LineInfo;
+    class DebugInfoAllocator;
+
+    // SimNode::debugInfo is allocated from the table of the NodeAllocator, which is currently making the node
+    extern DAS_THREAD_LOCAL DebugInfoAllocator * g_nodeLineInfoTable;
+
+    struct NodeLineInfoScope {
+        NodeLineInfoScope ( DebugInfoAllocator * table ) : saved(g_nodeLineInfoTable) { g_nodeLineInfoTable = table; }
+        ~NodeLineInfoScope() { g_nodeLineInfoTable = saved; }
+        DebugInfoAllocator * saved;
+    };
+#endif
+
+#if DAS_DEBUGGER
+    struct SimNode;
+
+    // statement, which is replaced with the single step trap while any context sharing the code is single stepping
+    struct SimNodeStepTrap {
+        SimNode **  slot;
+        SimNode *   node;
+        SimNode *   trap;
+    };
+#endif
+
     class NodeAllocator : public LinearChunkAllocator {
     public:
         bool prefixWithHeader = true;
         uint32_t totalNodesAllocated = 0;
+#if DAS_COMPACT_DEBUG_INFO
+        DebugInfoAllocator * lineInfoTable = nullptr;
+#endif
+#if DAS_DEBUGGER
+        bool patchSingleStep = false;           // release nodes, single step is done by patching statements with traps
+        int32_t stepTrapRefs = 0;               // number of contexts, which are single stepping this code
+        vector<SimNodeStepTrap> stepTraps;      // collected on the first single step
+#endif
     public:
         NodeAllocator() {}
 
@@ -461,6 +623,9 @@ namespace das {
         template<typename TT, typename... Params>
         TT * makeNode(Params... args) {
             totalNodesAllocated ++;
+#if DAS_COMPACT_DEBUG_INFO
+            NodeLineInfoScope lineInfoScope(lineInfoTable);
+#endif
             if ( prefixWithHeader ) {
                 char * data = allocate(sizeof(TT) + sizeof(NodePrefix));
                 new ((void *)data) NodePrefix(sizeof(TT));
@@ -473,6 +638,9 @@ namespace das {
         template<typename TT, typename... Params>
         __forceinline TT * makeNode(Params... args) {
             totalNodesAllocated++;
+#if DAS_COMPACT_DEBUG_INFO
+            NodeLineInfoScope lineInfoScope(lineInfoTable);
+#endif
             char * data = allocate(prefixWithHeader ? (sizeof(TT)+sizeof(NodePrefix)) : sizeof(TT));
             if ( prefixWithHeader ) {
                 new ((void *)data) NodePrefix(sizeof(TT));
@@ -714,11 +882,19 @@ namespace das {
         DebugInfoAllocator() {
             prefixWithHeader = false;
             initialSize = 1024;
+#if DAS_COMPACT_DEBUG_INFO
+            lineInfo.alignMask = 7;
+            lineInfo.initialSize = 4096;
+#endif
         }
         virtual uint32_t grow ( uint32_t size ) override {
             return size;
         }
         char * allocateCachedName ( const string & name );
+#if DAS_COMPACT_DEBUG_INFO
+        LineInfo * makeNodeLineInfo ( const LineInfo & at );
+        LinearChunkAllocator                 lineInfo;      // SimNode::debugInfo of all the nodes
+#endif
         das_hash_map<uint64_t,TypeInfo *>    lookup;
         das_hash_map<string, char *>         stringLookup;
         das_hash_map<string, wchar_t *>      stringWideLookup;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "daScript/simulate/simulate.h"
+
+namespace das
+{
+    // sampling heap profiler
+    //  samples on average one allocation per sampleRate bytes (poisson process, as in tcmalloc)
+    //  each sample remembers allocation LineInfo and script call stack, and stays live until freed
+    //  estimated totals are unsampled with the 1/(1-exp(-size/sampleRate)) weight
+    class HeapSampler {
+    public:
+        struct Frame {
+            const char *    function = nullptr;     // nullptr for the allocation site itself, or AOT
+            LineInfo        at;
+        };
+        struct Site {
+            vector<Frame>   stack;                  // stack[0] is allocation site
+            uint64_t        allocCount = 0;         // sampled allocations, ever
+            uint64_t        allocBytes = 0;
+            double          allocWeight = 0.;       // estimated allocations, ever
+            double          allocWeightBytes = 0.;
+        };
+        struct SiteStat {
+            uint64_t        count = 0;
+            uint64_t        bytes = 0;
+            double          weight = 0.;
+            double          weightBytes = 0.;
+        };
+        typedef das_map<uint32_t,SiteStat> Snapshot;
+    public:
+        HeapSampler ( uint64_t rate, int32_t depth );
+        void onAllocate ( Context * context, void * ptr, uint64_t size, const LineInfo & at );
+        void onReallocate ( Context * context, void * ptr, uint64_t size, void * newPtr, uint64_t newSize, const LineInfo & at );
+        void onFree ( void * ptr );
+        // allocations which go away without onFree, i.e. swept, evacuated from the nursery, or reset
+        void onMove ( void * ptr, void * newPtr );
+        void prune ( const callable<bool (void *, uint64_t)> & isLive );
+        void reset();
+        int32_t snapshot();
+        Snapshot live() const;
+        const Snapshot * getSnapshot ( int32_t index ) const;
+        void report ( TextWriter & tw, int32_t topN ) const;
+        void reportDiff ( TextWriter & tw, int32_t fromIndex, int32_t toIndex, int32_t topN ) const;
+        void writePprof ( TextWriter & tw, int32_t index, int32_t baseIndex ) const;
+        uint64_t getSampleRate() const { return sampleRate; }
+        bool ownsInstrumentation = false;           // context allocations were instrumented by the sampler
+    protected:
+        uint64_t nextSampleDistance();
+        uint32_t captureSite ( Context * context, const LineInfo & at );
+        Snapshot diff ( const Snapshot & from, const Snapshot & to ) const;
+        void reportStats ( TextWriter & tw, const Snapshot & snap, int32_t topN, const char * title ) const;
+        string describeSite ( uint32_t siteId ) const;
+    protected:
+        struct Sample {
+            uint32_t    site;
+            uint64_t    size;
+            double      weight;
+        };
+        uint64_t                        sampleRate;
+        int32_t                         maxDepth;
+        int64_t                         bytesUntilSample;
+        uint64_t                        rng;
+        vector<Site>                    sites;
+        das_hash_map<uint64_t,uint32_t> siteLookup;
+        das_hash_map<void *,Sample>     samples;
+        vector<Snapshot>                snapshots;
+    };
+
+    typedef unique_ptr<HeapSampler> HeapSamplerPtr;
+}
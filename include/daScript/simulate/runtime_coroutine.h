@@ -0,0 +1,75 @@
+#pragma once
+
+#include "daScript/simulate/simulate.h"
+
+namespace das
+{
+    // native coroutine scheduler
+    //  coroutine is iterator<bool>, which yields to let the others run
+    //  each scheduled coroutine owns the stack of frames; only the top frame is resumed
+    //  co_await of iterator<bool> under the scheduler registers the sub-coroutine, and yields false right away
+    //  when the scheduler gets false from the frame it resumed, it pushes the registered sub-coroutine onto the stack (symmetric transfer),
+    //  so resuming the coroutine nested N levels deep is a single iterator call, instead of N nested ones
+    //  the sub-coroutine stays owned by the awaiting one; when it is done, the awaiting coroutine continues right after its co_await
+    //  loops which do not yield (like cr_run) swallow the false, and the awaiting coroutine runs the sub-coroutine in place
+    class CoroutineScheduler {
+    public:
+        // frame stack of the scheduled coroutine; shallow stacks fit in place, deeper ones spill to the heap
+        struct Frames {
+            enum { smallDepth = 16 };
+            Sequence            root = { nullptr };     // scheduled coroutine, owned by the scheduler
+            Sequence *          small[smallDepth];      // small[0] is the root, top() is the one which runs
+            vector<Sequence *>  deep;
+            uint32_t            depth = 0;
+            __forceinline Sequence * top() const { return depth<=smallDepth ? small[depth-1] : deep.back(); }
+            __forceinline void push ( Sequence * it ) {
+                if ( depth<smallDepth ) small[depth] = it; else deep.push_back(it);
+                depth ++;
+            }
+            __forceinline void pop() {
+                if ( depth>smallDepth ) deep.pop_back();
+                depth --;
+            }
+        };
+        struct Coroutine {
+            Frames *    frames = nullptr;
+            int32_t     event = 0;              // event it waits for
+        };
+        enum class Status {
+            running,
+            waiting,
+            done
+        };
+        enum { framesPerChunk = 32 };
+    public:
+        CoroutineScheduler() {}
+        ~CoroutineScheduler();
+        void add ( Context * context, Sequence & it );
+        bool tick ( Context * context );
+        int32_t signal ( int32_t event );
+        void clear ( Context * context );
+        int32_t running() const { return int32_t(runQueue.size()); }
+        int32_t waiting() const { return totalWaiting; }
+        // called by the coroutine, which is being resumed, right before it yields false
+        static bool transfer ( Sequence & it );
+        static bool wait ( int32_t event );
+        // called by the coroutine right after that yield; request which is still there was swallowed by a loop
+        static void resumed();
+    protected:
+        Status resume ( Context * context, Coroutine & co );
+        void close ( Context * context, Coroutine & co );
+        Frames * allocFrames();
+        void freeFrames ( Frames * frames );
+        void clearRequest() { pendingAwait = nullptr; hasPendingEvent = false; }
+    protected:
+        vector<Coroutine>                           runQueue;
+        das_hash_map<int32_t,vector<Coroutine>>     waitQueue;
+        int32_t                                     totalWaiting = 0;
+        vector<Frames *>                            frameChunks;
+        vector<Frames *>                            framePool;
+        // request of the coroutine, which is being resumed; it is only valid until that coroutine yields
+        Sequence *                                  pendingAwait = nullptr;
+        int32_t                                     pendingEvent = 0;
+        bool                                        hasPendingEvent = false;
+    };
+}
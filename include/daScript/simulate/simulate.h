@@ -33,6 +33,8 @@ namespace das
 
     #if DAS_ENABLE_PROFILER
         #define DAS_PROFILE_NODE    profileNode(this);
+    #elif DAS_FUSION_PROFILE
+        #define DAS_PROFILE_NODE    profileFusionNode(this);
     #else
         #define DAS_PROFILE_NODE
     #endif
@@ -41,6 +43,7 @@ namespace das
     struct SimNode;
     struct Block;
     struct SimVisitor;
+    class HeapSampler;
 
     enum class ContextCategory : uint32_t {
         none =              0
@@ -94,8 +97,16 @@ namespace das
         const LineInfo * getLineInfo() const;
     };
 
+#if DAS_COMPACT_DEBUG_INFO
+    LineInfo & makeNodeLineInfo ( const LineInfo & at );
+#endif
+
     struct SimNode {
+#if DAS_COMPACT_DEBUG_INFO
+        SimNode ( const LineInfo & at ) : debugInfo(makeNodeLineInfo(at)) {}
+#else
         SimNode ( const LineInfo & at ) : debugInfo(at) {}
+#endif
         virtual SimNode * copyNode ( Context & context, NodeAllocator * code );
         DAS_EVAL_ABI virtual vec4f eval ( Context & ) = 0;
         virtual SimNode * visit ( SimVisitor & vis );
@@ -107,7 +118,11 @@ namespace das
         virtual uint32_t    evalUInt ( Context & context );
         virtual int64_t     evalInt64 ( Context & context );
         virtual uint64_t    evalUInt64 ( Context & context );
+#if DAS_COMPACT_DEBUG_INFO
+        LineInfo & debugInfo;       // lives in the DebugInfoAllocator of the context, away from the hot node data
+#else
         LineInfo debugInfo;
+#endif
         virtual bool rtti_node_isSourceBase() const { return false;  }
         virtual bool rtti_node_isBlock() const { return false; }
         virtual bool rtti_node_isIf() const { return false; }
@@ -148,6 +163,7 @@ namespace das
     ,   stopForContinue     = 1 << 2
     ,   jumpToLabel         = 1 << 3
     ,   yield               = 1 << 4
+    ,   stopForBudget       = 1 << 5    // set by ContextTenant, unwinds like return all the way to Context::call
     };
 
 #define DAS_PROCESS_LOOP_FLAGS(howtocontinue) \
@@ -276,7 +292,7 @@ namespace das
         friend class Module;
     public:
         Context(uint32_t stackSize = 16*1024, bool ph = false);
-        Context(const Context &, uint32_t category_);
+        Context(const Context &, uint32_t category_, bool runInit = true);
         Context(const Context &) = delete;
         Context & operator = (const Context &) = delete;
         virtual ~Context();
@@ -295,6 +311,10 @@ namespace das
         void onReallocate ( void * ptr, uint64_t size, void * newPtr, uint64_t newSize, const LineInfo & at );
         void onFree ( void * ptr, const LineInfo & at );
 
+        void enableHeapSampler ( uint64_t sampleRate, int32_t maxDepth );
+        void disableHeapSampler ();
+        void pruneHeapSampler ( bool all );    // after collection or reset, drops samples of memory which is gone
+
         __forceinline char * allocateIterator ( uint32_t size, const char * iterName, const LineInfo * at = nullptr ) {
             if ( instrumentAllocations ) {
                 auto aptr = heap->impl_allocateIterator(size, iterName, at);
@@ -313,23 +333,32 @@ namespace das
         __forceinline char * allocate ( uint32_t size, const LineInfo * at = nullptr ) {
             if ( instrumentAllocations ) {
                 auto aptr = heap->impl_allocate(size);
+                if ( !aptr && tenant ) aptr = reclaimAndAllocate(nullptr, 0, size);
                 onAllocate(aptr, size, at ? *at : LineInfo());
                 return aptr;
             } else {
-                return heap->impl_allocate(size);
+                auto aptr = heap->impl_allocate(size);
+                if ( !aptr && tenant ) aptr = reclaimAndAllocate(nullptr, 0, size);
+                return aptr;
             }
         }
 
         __forceinline char * reallocate ( char * ptr, uint32_t oldSize, uint32_t size, const LineInfo * at = nullptr ) {
             if ( instrumentAllocations ) {
                 auto aptr = heap->impl_reallocate(ptr, oldSize, size);
+                if ( !aptr && tenant ) aptr = reclaimAndAllocate(ptr, oldSize, size);
                 onReallocate(ptr, oldSize, aptr, size, at ? *at : LineInfo());
                 return aptr;
             } else {
-                return heap->impl_reallocate(ptr, oldSize, size);
+                auto aptr = heap->impl_reallocate(ptr, oldSize, size);
+                if ( !aptr && tenant ) aptr = reclaimAndAllocate(ptr, oldSize, size);
+                return aptr;
             }
         }
 
+        // allocation went over the tenant limit, idle contexts of the tenant are collected and it is tried again
+        char * reclaimAndAllocate ( char * ptr, uint32_t oldSize, uint32_t size );
+
         __forceinline void free ( char * ptr, uint32_t size, const LineInfo * at = nullptr ) {
             if ( instrumentAllocations ) onFree(ptr, at ? *at : LineInfo());
             heap->impl_free(ptr, size);
@@ -394,6 +423,9 @@ namespace das
             DAS_ASSERTF(insideContext==0,"can't reset heaps in locked context");
             heap->reset();
             stringHeap->reset();
+            heap->syncTenant();
+            stringHeap->syncTenant();
+            if ( heapSampler ) pruneHeapSampler(true);
             stringDisposeQue = nullptr;
         }
 
@@ -435,6 +467,16 @@ namespace das
         DAS_NORETURN_PREFIX void throw_fatal_error ( const char * message, const LineInfo & at ) DAS_NORETURN_SUFFIX;
         DAS_NORETURN_PREFIX void rethrow () DAS_NORETURN_SUFFIX;
         DAS_NORETURN_PREFIX void throw_out_of_memory ( bool stringHeap, uint32_t size, const LineInfo * at=nullptr ) DAS_NORETURN_SUFFIX;
+        DAS_NORETURN_PREFIX void throw_budget_exceeded ( const LineInfo * at ) DAS_NORETURN_SUFFIX;
+        // tenant stops the context from other threads, so the bit is set and cleared atomically.
+        //  context's own writes to stopFlags are not atomic, and can overwrite a stop which lands at the same instant;
+        //  ContextTenant::checkBudget stops the contexts again on every check, until the next time slice
+        __forceinline void setStopForBudget() { stopFlagsAtomic().fetch_or(EvalFlags::stopForBudget); }
+        __forceinline void clearStopForBudget() { stopFlagsAtomic().fetch_and(~uint32_t(EvalFlags::stopForBudget)); }
+        __forceinline atomic<uint32_t> & stopFlagsAtomic() {
+            static_assert(sizeof(atomic<uint32_t>)==sizeof(uint32_t), "stopFlags is accessed as atomic");
+            return *reinterpret_cast<atomic<uint32_t> *>(&stopFlags);
+        }
 
         __forceinline SimFunction * getFunction ( int index ) const {
             return (index>=0 && index<totalFunctions) ? functions + index : nullptr;
@@ -513,6 +555,7 @@ namespace das
 #endif
             // CALL
             fn->code->eval(*this);
+            if ( stopFlags & EvalFlags::stopForBudget ) throw_budget_exceeded(line);
             stopFlags = 0;
             // POP
             abiArg = aa;
@@ -525,6 +568,7 @@ namespace das
                 auto aa = abiArg;
                 abiArg = args;
                 result = fn->code->eval(*this);
+                if ( stopFlags & EvalFlags::stopForBudget ) throw_budget_exceeded(line);
                 stopFlags = 0;
                 abiArg = aa;
                 return result;
@@ -549,6 +593,7 @@ namespace das
 #endif
                 // CALL
                 fn->code->eval(*this);
+                if ( stopFlags & EvalFlags::stopForBudget ) throw_budget_exceeded(line);
                 stopFlags = 0;
                 // POP
                 abiArg = aa;
@@ -578,6 +623,7 @@ namespace das
 #endif
             // CALL
             fn->code->eval(*this);
+            if ( stopFlags & EvalFlags::stopForBudget ) throw_budget_exceeded(line);
             stopFlags = 0;
             // POP
             abiArg = aa; abiCMRES = acm;
@@ -657,6 +703,7 @@ namespace das
 #endif
             // CALL
             when(fn->code);
+            if ( stopFlags & EvalFlags::stopForBudget ) throw_budget_exceeded(line);
             stopFlags = 0;
             // POP
             abiArg = aa; abiCMRES = acm;
@@ -669,8 +716,12 @@ namespace das
         }
 
         void relocateCode( bool pwh = false );
+        int32_t hotPatch ( const smart_ptr<Context> & fresh );
         void announceCreation();
         void collectHeap(LineInfo * at, bool stringHeap, bool validate);
+        void collectNursery(LineInfo * at);
+        bool forkFrom ( Context & from, string & error );
+        void setTenant ( const smart_ptr<ContextTenant> & t );
         void reportAnyHeap(LineInfo * at, bool sth, bool rgh, bool rghOnly, bool errorsOnly);
         void instrumentFunction ( SimFunction * , bool isInstrumenting, uint64_t userData, bool threadLocal );
         void instrumentContextNode ( const Block & blk, bool isInstrumenting, Context * context, LineInfo * line );
@@ -712,7 +763,13 @@ namespace das
             }
         }
 
-        __forceinline void setSingleStep ( bool step ) { singleStepMode = step; }
+        __forceinline void setSingleStep ( bool step ) {
+#if DAS_DEBUGGER
+            if ( step!=singleStepMode && code && code->patchSingleStep ) patchSingleStep(step);
+#endif
+            singleStepMode = step;
+        }
+        void patchSingleStep ( bool step );
         void triggerHwBreakpoint ( void * addr, int index );
 
         __forceinline bool isGlobalPtr ( char * ptr ) const { return globals<=ptr && ptr<(globals+globalsSize); }
@@ -745,6 +802,18 @@ namespace das
         bool                            alwaysErrorOnException = false;
         bool                            alwaysStackWalkOnException = false;
         bool                            instrumentAllocations = false;
+        unique_ptr<HeapSampler>         heapSampler;
+        // code of the hot patched functions, and the function table it calls through.
+        //  the rest of the fresh context (heaps, globals, stack) is not kept
+        struct HotPatchGeneration {
+            shared_ptr<NodeAllocator>           code;
+            shared_ptr<DebugInfoAllocator>      debugInfo;
+            shared_ptr<ConstStringAllocator>    constStringHeap;
+            SimFunction *                       functions = nullptr;
+            int32_t                             totalFunctions = 0;
+        };
+        //  clones share the function table, so they share the generations, which outlive whoever is last to go
+        shared_ptr<vector<HotPatchGeneration>>  hotPatches;
     public:
         string                          name;
         Bitfield                        category = 0;
@@ -792,6 +861,7 @@ namespace das
         uint32_t gotoLabel = 0;
     public:
         recursive_mutex * contextMutex = nullptr;
+        smart_ptr<ContextTenant> tenant;
     protected:
         das_hash_map<void *, TypeInfo *> gcRoots;
     public:
@@ -883,6 +953,14 @@ __forceinline void profileNode ( SimNode * node ) {
     }
 }
 
+#elif DAS_FUSION_PROFILE
+
+extern DAS_THREAD_LOCAL das_hash_map<SimNode *,uint64_t> g_fusionProfile;
+
+__forceinline void profileFusionNode ( SimNode * node ) {
+    g_fusionProfile[node] ++;
+}
+
 #endif
 
 #define DAS_EVAL_NODE               \
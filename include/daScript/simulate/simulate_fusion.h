@@ -12,10 +12,29 @@ namespace das {
     typedef char * StringPtr;
     typedef void * VoidPtr;
 
+    // node kind is FNV-1a hash of the name node reports to SimVisitor::op
+    // patterns compare kinds as integers, and kinds of literal names are computed at compile time
+    constexpr uint64_t fusionKind ( const char * name, uint64_t hash = 14695981039346656037ull ) {
+        while ( *name ) {
+            hash = (hash ^ uint8_t(*name++)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // same as fusionKind(fuseName(name,typeName))
+    constexpr uint64_t fuseKind ( const char * name, const char * typeName ) {
+        return (typeName && *typeName) ? fusionKind(">",fusionKind(typeName,fusionKind("<",fusionKind(name)))) : fusionKind(name);
+    }
+
+    template <uint64_t kind>
+    struct FusionKindConst { static constexpr uint64_t value = kind; };
+
+    #define DAS_FUSION_KIND(name)   (das::FusionKindConst<das::fusionKind(name)>::value)
+
     struct SimNodeInfo {
-        string  name;
-        string  typeName;
-        size_t  typeSize;
+        uint64_t    kind = 0;       // fusionKind(name)
+        uint64_t    typeKind = 0;   // fusionKind(typeName)
+        uint64_t    fusedKind = 0;  // fuseKind(name,typeName), key in the fusion engine
     };
 
     typedef das_hash_map<SimNode *,SimNodeInfo> SimNodeInfoLookup;
@@ -24,13 +43,13 @@ namespace das {
         FusionPoint () {}
         virtual ~FusionPoint() {}
         virtual SimNode * fuse ( const SimNodeInfoLookup &, SimNode * node, Context * ) { return node; }
-        static bool is ( const SimNodeInfoLookup & info, SimNode * node, const char * name );
-        static bool is2 ( const SimNodeInfoLookup & info, SimNode * lnode, SimNode * rnode, const char * lname, const char * rname );
-        static bool is ( const SimNodeInfoLookup & info, SimNode * node, const char * name, const char * typeName );
+        static bool is ( const SimNodeInfoLookup & info, SimNode * node, uint64_t kind );
+        static bool is2 ( const SimNodeInfoLookup & info, SimNode * lnode, SimNode * rnode, uint64_t lkind, uint64_t rkind );
+        static bool is ( const SimNodeInfoLookup & info, SimNode * node, uint64_t kind, uint64_t typeKind );
     };
     typedef unique_ptr<FusionPoint> FusionPointPtr;
 
-    typedef das_hash_map<string,vector<FusionPointPtr>> FusionEngine;   // note: unordered map for thread safety
+    typedef das_hash_map<uint64_t,vector<FusionPointPtr>> FusionEngine;   // node kind -> fusion points
     extern DAS_THREAD_LOCAL unique_ptr<FusionEngine> g_fusionEngine;
 
     const char * getSimSourceName(SimSourceType st);
@@ -81,6 +100,17 @@ namespace das {
     void createFusionEngine();
     void registerFusion ( const char * OpName, const char * CTypeName, FusionPoint * node );
 
+#if DAS_FUSION_PROFILE
+    // workload profile of node kinds, which are left after fusion
+    void resetFusionProfile();
+#endif
+
+#if DAS_FUSION
+    // without DAS_FUSION_PROFILE each node counts once
+    void collectFusionProfile ( Context & context, TextWriter & tout, int topN );
+    void generateFusionPatterns ( Context & context, TextWriter & tout, int topN );
+#endif
+
 #if DAS_FUSION
     // fusion engine subsections
     // misc (note, misc before everything)
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "daScript/simulate/simulate_fusion_op2_generated.h"
+
 #define FUSION_OP2_PTR(CTYPE,expr)              (((CTYPE *)(expr)))
 #define FUSION_OP2_RVALUE_LEFT(CTYPE,expr)      (*((CTYPE *)(expr)))
 #define FUSION_OP2_RVALUE_RIGHT(CTYPE,expr)     (*((CTYPE *)(expr)))
@@ -0,0 +1,12 @@
+// generated by generateFusionPatterns from a workload profile, DAS_FUSION_PROFILE=1
+// included by simulate_fusion_op2.h, expanded by simulate_fusion_op2_impl.h and simulate_fusion_op2_set_impl.h with DAS_FUSION>=2
+
+#pragma once
+
+#define IMPLEMENT_OP2_GENERATED_NODES(INLINE,OPNAME,TYPE,CTYPE)
+
+#define MATCH_OP2_GENERATED(OPNAME)
+
+#define IMPLEMENT_OP2_SET_GENERATED_NODES(INLINE,OPNAME,TYPE,CTYPE)
+
+#define MATCH_OP2_SET_GENERATED(OPNAME)
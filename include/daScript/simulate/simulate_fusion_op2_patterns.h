@@ -0,0 +1,45 @@
+#pragma once
+
+// exact operand combinations of the op2 and setop fusion points with DAS_FUSION>=2
+//  each is PATTERN(INLINE,OPNAME,TYPE,CTYPE,LNODENAME,RNODENAME,COMPUTEL,COMPUTER)
+//  fusion points expand it into nodes and matches, generateFusionPatterns skips combinations listed here
+
+#define FUSION_OP2_PATTERNS(PATTERN,INLINE,OPNAME,TYPE,CTYPE) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetGlobalR2V","GetLocalR2V",Global,Local) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetThisBlockArgumentR2V","GetThisBlockArgument",ThisBlockArgumentRef,ThisBlockArgument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetThisBlockArgument","GetThisBlockArgument",ThisBlockArgument,ThisBlockArgument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetThisBlockArgument","GetArgument",ThisBlockArgument,Argument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgument","GetArgument",Argument,Argument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgument","GetLocalR2V",Argument,Local) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgument","ConstValue",Argument,Const) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgument","GetArgumentRefOffR2V",Argument,ArgumentRefOff) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalRefOffR2V","GetLocalRefOffR2V",LocalRefOff,LocalRefOff) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalRefOffR2V","GetLocalR2V",LocalRefOff,Local) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalRefOffR2V","GetArgument",LocalRefOff,Argument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalR2V","GetThisBlockArgumentR2V",Local,ThisBlockArgumentRef) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalR2V","GetLocalR2V",Local,Local) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalR2V","GetArgument",Local,Argument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalR2V","ConstValue",Local,Const) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"ConstValue","GetLocalR2V",Const,Local) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"ConstValue","GetLocalRefOffR2V",Const,LocalRefOff) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"ConstValue","GetArgument",Const,Argument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgumentRefOffR2V","GetArgumentRefOffR2V",ArgumentRefOff,ArgumentRefOff) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgumentRefOffR2V","GetArgument",ArgumentRefOff,Argument)
+
+#define FUSION_OP2_SET_PATTERNS(PATTERN,INLINE,OPNAME,TYPE,CTYPE) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetCMResOfs","ConstValue",CMResOfs,Const) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetGlobal","GetLocalR2V",Global,Local) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocal","ConstValue",Local,Const) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocal","GetLocalR2V",Local,Local) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocal","GetLocalRefOffR2V",Local,LocalRefOff) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalRefOff","GetLocalRefOffR2V",LocalRefOff,LocalRefOff) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalRefOff","GetArgument",LocalRefOff,Argument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetLocalRefOff","ConstValue",LocalRefOff,Const) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgumentRefOff","GetArgumentRefOffR2V",ArgumentRefOff,ArgumentRefOff) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgumentRefOff","GetLocalR2V",ArgumentRefOff,Local) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgument","ConstValue",ArgumentRef,Const) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgument","GetArgument",ArgumentRef,Argument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgument","GetLocalRefOffR2V",ArgumentRef,LocalRefOff) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetArgument","GetLocalR2V",ArgumentRef,Local) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetThisBlockArgument","GetThisBlockArgument",ThisBlockArgumentRef,ThisBlockArgument) \
+    PATTERN(INLINE,OPNAME,TYPE,CTYPE,"GetThisBlockArgument","GetThisBlockArgumentR2V",ThisBlockArgumentRef,ThisBlockArgumentRef)
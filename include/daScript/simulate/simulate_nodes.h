@@ -1615,11 +1615,39 @@ SIM_NODE_AT_VECTOR(Float, float)
     };
 
     // StringBuilder
+    enum class StringBuilderFormat : uint8_t {
+        skip,           // literal, which is already part of the previous segment
+        literal,        // pre-concatenated literal text
+        walk,           // anything else goes through the DebugDataWalker
+        boolean,
+        int32,
+        hex32,
+        int64,
+        hex64,
+        float32,
+        float64,
+        string
+    };
+
+    struct StringBuilderSegment {
+        const char *        text;
+        uint32_t            length;
+        StringBuilderFormat format;
+    };
+
+    uint32_t getStringBuilderScratchSize ( StringBuilderFormat format );
+
     struct SimNode_StringBuilder : SimNode_CallBase {
         SimNode_StringBuilder ( bool ts, const LineInfo & at ) : SimNode_CallBase(at), isTempString(ts) {}
+        virtual SimNode * copyNode ( Context & context, NodeAllocator * code ) override;
         virtual SimNode * visit ( SimVisitor & vis ) override;
         DAS_EVAL_ABI virtual vec4f eval ( Context & context ) override;
-        bool isTempString;
+        char * buildString ( Context & context, vec4f * argValues );
+        char * walkString ( Context & context, vec4f * argValues );
+        StringBuilderSegment *  segments = nullptr;
+        uint32_t                scratchSize = 0;    // upper bound of all formatted numbers
+        bool                    hasWalk = false;
+        bool                    isTempString;
     };
 
     // CAST
@@ -2458,6 +2486,21 @@ SIM_NODE_AT_VECTOR(Float, float)
         bool        persistent;
     };
 
+    struct SimNode_NewOnStack : SimNode {
+        DAS_PTR_NODE;
+        SimNode_NewOnStack ( const LineInfo & at, int32_t b, uint32_t sp )
+            : SimNode(at), bytes(b), stackTop(sp) {}
+        virtual SimNode * visit ( SimVisitor & vis ) override;
+        __forceinline char * compute ( Context & context ) {
+            DAS_PROFILE_NODE
+            char * ptr = context.stack.sp() + stackTop;
+            memset ( ptr, 0, bytes );
+            return ptr;
+        }
+        int32_t     bytes;
+        uint32_t    stackTop;
+    };
+
     template <bool move>
     struct SimNode_Ascend : SimNode {
         DAS_PTR_NODE;
@@ -2937,6 +2980,27 @@ SIM_NODE_AT_VECTOR(Float, float)
         SimNode * subexpr;
     };
 
+    // single step trap, which replaces the statement while the context is single stepping (see CodeOfPolicies::debugger_patching)
+    struct SimNodeDebug_SingleStep : SimNode {
+        SimNodeDebug_SingleStep ( const LineInfo & at, SimNode * se )
+            : SimNode(at), subexpr(se) {}
+        virtual SimNode * visit ( SimVisitor & vis ) override;
+        DAS_EVAL_ABI virtual vec4f eval ( Context & context ) override {
+            DAS_PROFILE_NODE
+            DAS_SINGLE_STEP(context,subexpr->debugInfo,false);
+            return subexpr->eval(context);
+        }
+#define EVAL_NODE(TYPE,CTYPE) \
+        virtual CTYPE eval##TYPE ( Context & context ) override { \
+                DAS_PROFILE_NODE \
+                DAS_SINGLE_STEP(context,subexpr->debugInfo,false); \
+                return subexpr->eval##TYPE(context); \
+            }
+        DAS_EVAL_NODE
+#undef EVAL_NODE
+        SimNode * subexpr;
+    };
+
     struct SimNodeDebug_InstrumentFunction : SimNode {
         SimNodeDebug_InstrumentFunction ( const LineInfo & at, SimFunction * simF, int64_t mnh, SimNode * se, uint64_t ud )
             : SimNode(at), func(simF), fnMnh(mnh), subexpr(se), userData(ud) {}
@@ -33,6 +33,7 @@
 
 #include "volume_mixer.h"
 #include "hrtf.h"
+#include "mixing_graph.h"
 
 #define I3DL32_REVERB_IMPLEMENTATION    1
 #include "reverb.h"
@@ -193,6 +194,8 @@ MAKE_TYPE_FACTORY(I3DL2Reverb,I3DL2Reverb);
 
 MAKE_TYPE_FACTORY(ma_hrtf,ma_hrtf);
 
+MAKE_TYPE_FACTORY(ma_mixing_graph,ma_mixing_graph);
+
 namespace das {
 
 static ma_device g_device;
@@ -443,6 +446,15 @@ struct MAHrtfAnnotation : ManagedStructureAnnotation<ma_hrtf> {
     }
 };
 
+struct MAMixingGraphAnnotation : ManagedStructureAnnotation<ma_mixing_graph,true,true> {
+    MAMixingGraphAnnotation ( ModuleLibrary & mlib )
+        : ManagedStructureAnnotation("ma_mixing_graph", mlib, "ma_mixing_graph") {
+        addField<DAS_BIND_MANAGED_FIELD(sampleRate)>("sampleRate","sampleRate");
+        addField<DAS_BIND_MANAGED_FIELD(maxJobs)>("maxJobs","maxJobs");
+        addField<DAS_BIND_MANAGED_FIELD(limiter)>("limiter","limiter");
+    }
+};
+
 void dasAudio_setSampleRate ( I3DL2Reverb * reverb, float rate, Context * context, LineInfoArg * at ) {
     if ( !reverb ) context->throw_error_at(at,"reverb is null");
     reverb->SetSampleRate(rate);
@@ -618,6 +630,34 @@ public:
             SideEffects::modifyArgument, "ma_hrtf_set_direction")->args({"hrtf", "azimuth", "elevation"});
         addExtern<DAS_BIND_FUN(ma_hrtf_uninit)>(*this, lib, "ma_hrtf_uninit",
             SideEffects::modifyArgument, "ma_hrtf_uninit")->args({"hrtf"});
+        // mixing graph
+        addAnnotation(make_smart<MAMixingGraphAnnotation>(lib));
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_init)>(*this, lib, "ma_mixing_graph_init",
+            SideEffects::modifyArgument, "ma_mixing_graph_init")->args({"graph", "sampleRate"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_uninit)>(*this, lib, "ma_mixing_graph_uninit",
+            SideEffects::modifyArgument, "ma_mixing_graph_uninit")->args({"graph"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_set_limiter)>(*this, lib, "ma_mixing_graph_set_limiter",
+            SideEffects::modifyArgument, "ma_mixing_graph_set_limiter")->args({"graph", "threshold", "attack_time", "release_time"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_add_bus)>(*this, lib, "ma_mixing_graph_add_bus",
+            SideEffects::modifyArgument, "ma_mixing_graph_add_bus")->args({"graph", "volume"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_set_bus_volume)>(*this, lib, "ma_mixing_graph_set_bus_volume",
+            SideEffects::modifyArgument, "ma_mixing_graph_set_bus_volume")->args({"graph", "bus", "volume"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_add_voice)>(*this, lib, "ma_mixing_graph_add_voice",
+            SideEffects::modifyArgument, "ma_mixing_graph_add_voice")->args({"graph", "pcm", "nFrames", "nChannels", "bus", "loop"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_set_volume)>(*this, lib, "ma_mixing_graph_set_volume",
+            SideEffects::modifyArgument, "ma_mixing_graph_set_volume")->args({"graph", "voice", "volume"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_set_pan)>(*this, lib, "ma_mixing_graph_set_pan",
+            SideEffects::modifyArgument, "ma_mixing_graph_set_pan")->args({"graph", "voice", "pan"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_set_direction)>(*this, lib, "ma_mixing_graph_set_direction",
+            SideEffects::modifyArgument, "ma_mixing_graph_set_direction")->args({"graph", "voice", "azimuth", "elevation"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_stop)>(*this, lib, "ma_mixing_graph_stop",
+            SideEffects::modifyArgument, "ma_mixing_graph_stop")->args({"graph", "voice"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_is_playing)>(*this, lib, "ma_mixing_graph_is_playing",
+            SideEffects::none, "ma_mixing_graph_is_playing")->args({"graph", "voice"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_render)>(*this, lib, "ma_mixing_graph_render",
+            SideEffects::modifyArgumentAndExternal, "ma_mixing_graph_render")->args({"graph", "pOut", "frameCount"});
+        addExtern<DAS_BIND_FUN(ma_mixing_graph_render_wav)>(*this, lib, "ma_mixing_graph_render_wav",
+            SideEffects::modifyArgumentAndExternal, "ma_mixing_graph_render_wav")->args({"graph", "fileName", "frameCount"});
         return true;
     }
     virtual ModuleAotType aotRequire ( TextWriter & tw ) const override {
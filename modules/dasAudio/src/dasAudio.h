@@ -2,6 +2,7 @@
 #include <miniaudio.h>
 #include "volume_mixer.h"
 #include "hrtf.h"
+#include "mixing_graph.h"
 #include "reverb.h"
 
 namespace das {
@@ -60,8 +60,9 @@ void ma_hrtf_process_channel ( ma_hrtf* hrtf, float* pOut, const float* pInBuffe
     for ( uint32_t i=0; i!=frameCount; ++i ) {
         pIn[i+hist] = pInBuffer[i];
     }
+    // history is the tail of history + input, which also works when frameCount < hist
     for ( ma_uint32 i=0; i!=hist; i++ ) {
-        history[i] = pInBuffer[frameCount + i - hist];
+        history[i] = pIn[frameCount + i];
     }
 
     float * outBuf = hrtf->mixbuffer;
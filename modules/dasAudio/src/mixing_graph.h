@@ -0,0 +1,380 @@
+#ifndef mixing_graph_h
+#define mixing_graph_h
+
+// offline mixing graph: voice -> (hrtf) -> bus -> limiter
+// voices are processed in blocks with vecmath kernels, independent voices are spread across the job queue
+// it does not need a device, render to a buffer or to a wav file
+// #include <miniaudio.h>
+// #include "volume_mixer.h"
+// #include "hrtf.h"
+
+#include "daScript/misc/job_que.h"
+
+#define MA_MIX_BLOCK    512     // frames per voice block, hrtf needs at least taps + HRTF_OVERLAP
+#define MA_MIX_SEGMENT  4096    // frames mixed per job queue pass
+#define MA_MIX_CHANNELS 2       // graph output is always stereo
+
+struct ma_mix_voice {
+    das::vector<float>  pcm;
+    uint64_t    nFrames;
+    uint32_t    nChannels;
+    uint64_t    cursor;
+    int32_t     bus;
+    bool        loop;
+    bool        playing;
+    bool        spatial;
+    float       volume;
+    float       tvolume;
+    float       pan;
+    ma_hrtf     hrtf;
+};
+
+struct ma_mix_job {
+    das::vector<float>  buses;      // nBuses * MA_MIX_SEGMENT * MA_MIX_CHANNELS
+    das::vector<float>  input;      // MA_MIX_BLOCK * 2, wrapped or padded source
+    das::vector<float>  spatial;    // MA_MIX_BLOCK * MA_MIX_CHANNELS, hrtf output
+};
+
+struct ma_mixing_graph {
+    uint32_t    sampleRate = 0;
+    int32_t     maxJobs = 0;        // 0 - as many as the job queue has, 1 - on the calling thread
+    das::vector<ma_mix_voice>   voices;
+    das::vector<float>          busVolume;
+    das::vector<ma_mix_job>     jobs;
+    das::vector<float>          pending;    // mixed, but not yet limited frames
+    ma_limiter  limiter;
+    das::shared_ptr<das::JobQue> jobQue;
+};
+
+void ma_mixing_graph_init ( ma_mixing_graph * graph, uint32_t sampleRate );
+void ma_mixing_graph_uninit ( ma_mixing_graph * graph );
+void ma_mixing_graph_set_limiter ( ma_mixing_graph * graph, float threshold, float attack_time, float release_time );
+int32_t ma_mixing_graph_add_bus ( ma_mixing_graph * graph, float volume );
+void ma_mixing_graph_set_bus_volume ( ma_mixing_graph * graph, int32_t bus, float volume );
+int32_t ma_mixing_graph_add_voice ( ma_mixing_graph * graph, const float * pcm, uint64_t nFrames, uint32_t nChannels, int32_t bus, bool loop );
+void ma_mixing_graph_set_volume ( ma_mixing_graph * graph, int32_t voice, float volume );
+void ma_mixing_graph_set_pan ( ma_mixing_graph * graph, int32_t voice, float pan );
+void ma_mixing_graph_set_direction ( ma_mixing_graph * graph, int32_t voice, int32_t azimuth, int32_t elevation );
+void ma_mixing_graph_stop ( ma_mixing_graph * graph, int32_t voice );
+bool ma_mixing_graph_is_playing ( ma_mixing_graph * graph, int32_t voice );
+void ma_mixing_graph_render ( ma_mixing_graph * graph, float * OutFrames, uint64_t nFrames );
+bool ma_mixing_graph_render_wav ( ma_mixing_graph * graph, const char * fileName, uint64_t nFrames );
+
+#ifdef MINIAUDIO_IMPLEMENTATION
+
+namespace das {
+    extern mutex              g_jobQueMutex;
+    extern shared_ptr<JobQue> g_jobQue;
+}
+
+// dst[stereo] += src[mono] * gain, gain of channel c goes from gc to gc + dc * n
+void ma_mix_kernel_mono ( float * dst, const float * src, uint32_t n, float g0, float g1, float d0, float d1 ) {
+    uint32_t i = 0;
+    if ( n >= 4 ) {
+        vec4f glo = v_make_vec4f(g0, g1, g0 + d0, g1 + d1);
+        vec4f ghi = v_add(glo, v_make_vec4f(d0 * 2.0f, d1 * 2.0f, d0 * 2.0f, d1 * 2.0f));
+        vec4f step = v_make_vec4f(d0 * 4.0f, d1 * 4.0f, d0 * 4.0f, d1 * 4.0f);
+        for ( ; i + 4 <= n; i += 4 ) {
+            vec4f s = v_ldu(src + i);
+            v_stu(dst + i*2 + 0, v_madd(v_perm_xxyy(s), glo, v_ldu(dst + i*2 + 0)));
+            v_stu(dst + i*2 + 4, v_madd(v_perm_zzww(s), ghi, v_ldu(dst + i*2 + 4)));
+            glo = v_add(glo, step);
+            ghi = v_add(ghi, step);
+        }
+    }
+    for ( ; i != n; ++i ) {
+        dst[i*2+0] += src[i] * (g0 + d0 * float(i));
+        dst[i*2+1] += src[i] * (g1 + d1 * float(i));
+    }
+}
+
+// dst[stereo] += src[stereo] * gain
+void ma_mix_kernel_stereo ( float * dst, const float * src, uint32_t n, float g0, float g1, float d0, float d1 ) {
+    uint32_t i = 0;
+    if ( n >= 2 ) {
+        vec4f g = v_make_vec4f(g0, g1, g0 + d0, g1 + d1);
+        vec4f step = v_make_vec4f(d0 * 2.0f, d1 * 2.0f, d0 * 2.0f, d1 * 2.0f);
+        for ( ; i + 2 <= n; i += 2 ) {
+            v_stu(dst + i*2, v_madd(v_ldu(src + i*2), g, v_ldu(dst + i*2)));
+            g = v_add(g, step);
+        }
+    }
+    for ( ; i != n; ++i ) {
+        dst[i*2+0] += src[i*2+0] * (g0 + d0 * float(i));
+        dst[i*2+1] += src[i*2+1] * (g1 + d1 * float(i));
+    }
+}
+
+// dst[i] += src[i] * gain, for n samples
+void ma_mix_kernel_accumulate ( float * dst, const float * src, uint64_t n, float gain ) {
+    uint64_t i = 0;
+    vec4f g = v_splats(gain);
+    for ( ; i + 16 <= n; i += 16 ) {
+        v_stu(dst + i + 0,  v_madd(v_ldu(src + i + 0),  g, v_ldu(dst + i + 0)));
+        v_stu(dst + i + 4,  v_madd(v_ldu(src + i + 4),  g, v_ldu(dst + i + 4)));
+        v_stu(dst + i + 8,  v_madd(v_ldu(src + i + 8),  g, v_ldu(dst + i + 8)));
+        v_stu(dst + i + 12, v_madd(v_ldu(src + i + 12), g, v_ldu(dst + i + 12)));
+    }
+    for ( ; i + 4 <= n; i += 4 ) {
+        v_stu(dst + i, v_madd(v_ldu(src + i), g, v_ldu(dst + i)));
+    }
+    for ( ; i != n; ++i ) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+void ma_mixing_graph_init ( ma_mixing_graph * graph, uint32_t sampleRate ) {
+    graph->sampleRate = sampleRate;
+    graph->maxJobs = 0;
+    graph->voices.clear();
+    graph->busVolume.clear();
+    graph->busVolume.push_back(1.0f);   // bus 0 is always there
+    graph->jobs.clear();
+    graph->pending.clear();
+    ma_limiter_init(&graph->limiter, 0.95f, 0.0001f, 0.01f, float(sampleRate), MA_MIX_CHANNELS);
+}
+
+void ma_mixing_graph_uninit ( ma_mixing_graph * graph ) {
+    for ( auto & voice : graph->voices ) {
+        if ( voice.spatial ) ma_hrtf_uninit(&voice.hrtf);
+    }
+    graph->voices.clear();
+    graph->jobs.clear();
+    graph->pending.clear();
+    graph->jobQue.reset();
+}
+
+void ma_mixing_graph_set_limiter ( ma_mixing_graph * graph, float threshold, float attack_time, float release_time ) {
+    ma_limiter_init(&graph->limiter, threshold, attack_time, release_time, float(graph->sampleRate), MA_MIX_CHANNELS);
+    graph->pending.clear();
+}
+
+int32_t ma_mixing_graph_add_bus ( ma_mixing_graph * graph, float volume ) {
+    graph->busVolume.push_back(volume);
+    return int32_t(graph->busVolume.size()) - 1;
+}
+
+void ma_mixing_graph_set_bus_volume ( ma_mixing_graph * graph, int32_t bus, float volume ) {
+    if ( bus<0 || bus>=int32_t(graph->busVolume.size()) ) return;
+    graph->busVolume[bus] = volume;
+}
+
+int32_t ma_mixing_graph_add_voice ( ma_mixing_graph * graph, const float * pcm, uint64_t nFrames, uint32_t nChannels, int32_t bus, bool loop ) {
+    if ( nChannels<1 || nChannels>2 || !nFrames ) return -1;
+    if ( bus<0 || bus>=int32_t(graph->busVolume.size()) ) return -1;
+    graph->voices.emplace_back();
+    auto & voice = graph->voices.back();
+    voice.pcm.assign(pcm, pcm + nFrames * nChannels);
+    voice.nFrames = nFrames;
+    voice.nChannels = nChannels;
+    voice.cursor = 0;
+    voice.bus = bus;
+    voice.loop = loop;
+    voice.playing = true;
+    voice.spatial = false;
+    voice.volume = voice.tvolume = 1.0f;
+    voice.pan = 0.0f;
+    memset(&voice.hrtf, 0, sizeof(ma_hrtf));
+    return int32_t(graph->voices.size()) - 1;
+}
+
+void ma_mixing_graph_set_volume ( ma_mixing_graph * graph, int32_t voice, float volume ) {
+    if ( voice<0 || voice>=int32_t(graph->voices.size()) ) return;
+    graph->voices[voice].tvolume = volume;  // ramps over the next block
+}
+
+void ma_mixing_graph_set_pan ( ma_mixing_graph * graph, int32_t voice, float pan ) {
+    if ( voice<0 || voice>=int32_t(graph->voices.size()) ) return;
+    graph->voices[voice].pan = ma_max(ma_min(pan,1.0f),-1.0f);
+}
+
+void ma_mixing_graph_set_direction ( ma_mixing_graph * graph, int32_t voice, int32_t azimuth, int32_t elevation ) {
+    if ( voice<0 || voice>=int32_t(graph->voices.size()) ) return;
+    auto & v = graph->voices[voice];
+    if ( !v.spatial ) {
+        ma_hrtf_init(&v.hrtf, graph->sampleRate);
+        if ( !v.hrtf.taps ) return;     // no hrtf for this sample rate, keep panning
+        v.spatial = true;
+    }
+    ma_hrtf_set_direction(&v.hrtf, azimuth, elevation);
+}
+
+void ma_mixing_graph_stop ( ma_mixing_graph * graph, int32_t voice ) {
+    if ( voice<0 || voice>=int32_t(graph->voices.size()) ) return;
+    graph->voices[voice].playing = false;
+}
+
+bool ma_mixing_graph_is_playing ( ma_mixing_graph * graph, int32_t voice ) {
+    if ( voice<0 || voice>=int32_t(graph->voices.size()) ) return false;
+    return graph->voices[voice].playing;
+}
+
+// returns n frames of the voice, wrapped or padded with silence into scratch when needed
+const float * ma_mix_voice_fetch ( ma_mix_voice * voice, float * scratch, uint32_t n ) {
+    uint32_t nChannels = voice->nChannels;
+    if ( voice->cursor + n <= voice->nFrames ) {
+        const float * res = voice->pcm.data() + voice->cursor * nChannels;
+        voice->cursor += n;
+        return res;
+    }
+    uint32_t done = 0;
+    while ( done != n ) {
+        uint64_t left = voice->nFrames - voice->cursor;
+        uint32_t count = uint32_t(ma_min(uint64_t(n - done), left));
+        memcpy(scratch + done * nChannels, voice->pcm.data() + voice->cursor * nChannels, count * nChannels * sizeof(float));
+        done += count;
+        voice->cursor += count;
+        if ( voice->cursor == voice->nFrames ) {
+            if ( voice->loop ) {
+                voice->cursor = 0;
+            } else {
+                memset(scratch + done * nChannels, 0, (n - done) * nChannels * sizeof(float));
+                voice->playing = false;
+                break;
+            }
+        }
+    }
+    return scratch;
+}
+
+void ma_mix_voice_block ( ma_mix_voice * voice, ma_mix_job * job, float * dst, uint32_t n ) {
+    const float * src = ma_mix_voice_fetch(voice, job->input.data(), n);
+    float volume = voice->volume;
+    float dvolume = (voice->tvolume - volume) / float(n);
+    voice->volume = voice->tvolume;
+    if ( voice->spatial ) {
+        float * spatial = job->spatial.data();
+        ma_hrtf_process_frames(&voice->hrtf, spatial, src, voice->nChannels, n);
+        ma_mix_kernel_stereo(dst, spatial, n, volume, volume, dvolume, dvolume);
+    } else {
+        // same pan law as ma_volume_mixer
+        float p0 = ma_min(1.0f - voice->pan, 1.0f);
+        float p1 = ma_min(1.0f + voice->pan, 1.0f);
+        if ( voice->nChannels == 1 ) {
+            ma_mix_kernel_mono(dst, src, n, volume * p0, volume * p1, dvolume * p0, dvolume * p1);
+        } else {
+            ma_mix_kernel_stereo(dst, src, n, volume * p0, volume * p1, dvolume * p0, dvolume * p1);
+        }
+    }
+}
+
+// mixes n <= MA_MIX_SEGMENT frames of all voices into dst
+void ma_mixing_graph_mix_segment ( ma_mixing_graph * graph, float * dst, uint32_t n, das::JobQue * jq ) {
+    uint32_t nBuses = uint32_t(graph->busVolume.size());
+    uint32_t nVoices = uint32_t(graph->voices.size());
+    uint32_t nJobs = uint32_t(graph->jobs.size());
+    uint64_t busStride = uint64_t(MA_MIX_SEGMENT) * MA_MIX_CHANNELS;
+    auto mix = [&]( int from, int to ) {
+        for ( int j=from; j<to; ++j ) {
+            auto & job = graph->jobs[j];
+            for ( uint32_t b=0; b!=nBuses; ++b ) {
+                memset(job.buses.data() + b * busStride, 0, n * MA_MIX_CHANNELS * sizeof(float));
+            }
+            // voices are interleaved between jobs, so that long and short voices spread evenly
+            for ( uint32_t vi=j; vi<nVoices; vi+=nJobs ) {
+                auto & voice = graph->voices[vi];
+                float * bus = job.buses.data() + voice.bus * busStride;
+                for ( uint32_t ofs=0; ofs<n && voice.playing; ofs+=MA_MIX_BLOCK ) {
+                    ma_mix_voice_block(&voice, &job, bus + ofs * MA_MIX_CHANNELS, ma_min(n - ofs, uint32_t(MA_MIX_BLOCK)));
+                }
+            }
+        }
+    };
+    if ( jq && nJobs > 1 ) {
+        jq->parallel_for(0, int(nJobs), mix, 0, das::JobPriority::High, int(nJobs));
+    } else {
+        mix(0, int(nJobs));
+    }
+    for ( uint32_t b=0; b!=nBuses; ++b ) {
+        for ( uint32_t j=0; j!=nJobs; ++j ) {
+            ma_mix_kernel_accumulate(dst, graph->jobs[j].buses.data() + b * busStride, uint64_t(n) * MA_MIX_CHANNELS, graph->busVolume[b]);
+        }
+    }
+}
+
+void ma_mixing_graph_prepare_jobs ( ma_mixing_graph * graph, das::JobQue * jq ) {
+    uint32_t nJobs = jq ? uint32_t(jq->getTotalHwJobs()) : 1;
+    if ( graph->maxJobs > 0 ) nJobs = ma_min(nJobs, uint32_t(graph->maxJobs));
+    nJobs = ma_max(ma_min(nJobs, uint32_t(graph->voices.size())), 1u);
+    size_t busSize = graph->busVolume.size() * MA_MIX_SEGMENT * MA_MIX_CHANNELS;
+    graph->jobs.resize(nJobs);
+    for ( auto & job : graph->jobs ) {
+        if ( job.buses.size() != busSize ) job.buses.resize(busSize);
+        if ( job.input.empty() ) {
+            job.input.resize(MA_MIX_BLOCK * 2);
+            job.spatial.resize(MA_MIX_BLOCK * MA_MIX_CHANNELS);
+        }
+    }
+}
+
+void ma_mixing_graph_render ( ma_mixing_graph * graph, float * OutFrames, uint64_t nFrames ) {
+    das::shared_ptr<das::JobQue> jq;
+    if ( graph->maxJobs != 1 ) {
+        {
+            das::lock_guard<das::mutex> guard(das::g_jobQueMutex);
+            jq = das::g_jobQue;
+        }
+        if ( !jq ) {
+            if ( !graph->jobQue ) graph->jobQue = das::make_shared<das::JobQue>();
+            jq = graph->jobQue;
+        }
+    }
+    ma_mixing_graph_prepare_jobs(graph, jq.get());
+    // same look-ahead scheme as the audio_boost mixer: keep attack_samples of mixed frames ahead of the output
+    uint64_t required = ma_limiter_get_required_input_frame_count(&graph->limiter, nFrames);
+    uint64_t current = graph->pending.size() / MA_MIX_CHANNELS;
+    uint64_t missing = required - current;
+    graph->pending.resize(required * MA_MIX_CHANNELS, 0.0f);
+    float * mix = graph->pending.data() + current * MA_MIX_CHANNELS;
+    memset(mix, 0, missing * MA_MIX_CHANNELS * sizeof(float));
+    for ( uint64_t ofs=0; ofs<missing; ofs+=MA_MIX_SEGMENT ) {
+        uint32_t n = uint32_t(ma_min(missing - ofs, uint64_t(MA_MIX_SEGMENT)));
+        ma_mixing_graph_mix_segment(graph, mix + ofs * MA_MIX_CHANNELS, n, jq.get());
+    }
+    ma_limiter_process_pcm_frames(&graph->limiter, graph->pending.data(), OutFrames, nFrames);
+    graph->pending.erase(graph->pending.begin(), graph->pending.begin() + nFrames * MA_MIX_CHANNELS);
+}
+
+void ma_mix_write_u32 ( FILE * f, uint32_t value ) {
+    uint8_t bytes[4] = { uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24) };
+    fwrite(bytes, 1, 4, f);
+}
+
+void ma_mix_write_u16 ( FILE * f, uint16_t value ) {
+    uint8_t bytes[2] = { uint8_t(value), uint8_t(value >> 8) };
+    fwrite(bytes, 1, 2, f);
+}
+
+// 32-bit float wav
+bool ma_mixing_graph_render_wav ( ma_mixing_graph * graph, const char * fileName, uint64_t nFrames ) {
+    if ( !fileName ) return false;
+    uint64_t dataSize = nFrames * MA_MIX_CHANNELS * sizeof(float);
+    if ( dataSize > 0xffffffffull - 36 ) return false;
+    FILE * f = fopen(fileName, "wb");
+    if ( !f ) return false;
+    fwrite("RIFF", 1, 4, f);
+    ma_mix_write_u32(f, uint32_t(36 + dataSize));
+    fwrite("WAVEfmt ", 1, 8, f);
+    ma_mix_write_u32(f, 16);
+    ma_mix_write_u16(f, 3);     // WAVE_FORMAT_IEEE_FLOAT
+    ma_mix_write_u16(f, MA_MIX_CHANNELS);
+    ma_mix_write_u32(f, graph->sampleRate);
+    ma_mix_write_u32(f, graph->sampleRate * MA_MIX_CHANNELS * uint32_t(sizeof(float)));
+    ma_mix_write_u16(f, MA_MIX_CHANNELS * sizeof(float));
+    ma_mix_write_u16(f, 32);
+    fwrite("data", 1, 4, f);
+    ma_mix_write_u32(f, uint32_t(dataSize));
+    das::vector<float> buffer(MA_MIX_SEGMENT * MA_MIX_CHANNELS);
+    bool ok = true;
+    for ( uint64_t ofs=0; ofs<nFrames && ok; ofs+=MA_MIX_SEGMENT ) {
+        uint64_t n = ma_min(nFrames - ofs, uint64_t(MA_MIX_SEGMENT));
+        ma_mixing_graph_render(graph, buffer.data(), n);
+        ok = fwrite(buffer.data(), sizeof(float) * MA_MIX_CHANNELS, size_t(n), f) == size_t(n);
+    }
+    fclose(f);
+    return ok;
+}
+
+#endif
+
+#endif
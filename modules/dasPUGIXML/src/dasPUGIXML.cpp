@@ -5,6 +5,7 @@
 #include "daScript/ast/ast_typefactory_bind.h"
 #include "daScript/ast/ast_handle.h"
 #include "daScript/simulate/bind_enum.h"
+#include "daScript/simulate/hash.h"
 
 #include "dasPUGIXML.h"
 
@@ -177,6 +178,216 @@ bool pugiAttribute_as_bool ( const pugi::xml_attribute & attr, bool def ) {
     return attr.as_bool(def);
 }
 
+// xml to struct
+
+enum class XmlFieldKind {
+    value,
+    structure,
+    array_of_values,
+    array_of_structures
+};
+
+struct XmlStructPlan;
+
+struct XmlFieldPlan {
+    string          name;
+    XmlFieldKind    kind;
+    Type            type;           // value, or array element type
+    uint32_t        offset;
+    uint32_t        stride;         // array element size
+    XmlStructPlan * plan;           // structure, or array element structure
+};
+
+struct XmlStructPlan {
+    uint64_t                        hash = 0;
+    vector<XmlFieldPlan>            fields;
+    das_hash_map<uint64_t,int32_t>  index;      // field name hash -> field
+};
+
+static bool xml_is_value_type ( Type type ) {
+    switch ( type ) {
+    case Type::tBool:
+    case Type::tInt8:   case Type::tUInt8:
+    case Type::tInt16:  case Type::tUInt16:
+    case Type::tInt:    case Type::tUInt:
+    case Type::tInt64:  case Type::tUInt64:
+    case Type::tFloat:  case Type::tDouble:
+    case Type::tString:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// plans are built once per structure layout, and reused for every node
+// they are keyed by the layout, and not by StructInfo, which does not outlive its context
+static DAS_THREAD_LOCAL das_hash_map<uint64_t,unique_ptr<XmlStructPlan>> g_xmlPlans;
+// plans which are still being built - nested and recursive fields resolve to them
+static DAS_THREAD_LOCAL das_hash_map<uint64_t,unique_ptr<XmlStructPlan>> g_xmlPlansBuilding;
+
+static uint64_t xml_plan_key ( StructInfo * si ) {
+    const uint64_t prime = 1099511628211ull;
+    uint64_t key = (si->hash ^ si->size) * prime;
+    for ( uint32_t i=0; i!=si->count; ++i ) {
+        VarInfo * vi = si->fields[i];
+        key = (key ^ hash_blockz64((const uint8_t *)vi->name)) * prime;
+        key = (key ^ vi->hash) * prime;
+        key = (key ^ ((uint64_t(vi->offset)<<8) | uint64_t(vi->type))) * prime;
+    }
+    return key;
+}
+
+static XmlStructPlan * xml_struct_plan ( StructInfo * si, Context & context, LineInfo * at ) {
+    uint64_t key = xml_plan_key(si);
+    auto it = g_xmlPlans.find(key);
+    if ( it!=g_xmlPlans.end() ) return it->second.get();
+    auto itb = g_xmlPlansBuilding.find(key);
+    if ( itb!=g_xmlPlansBuilding.end() ) return itb->second.get();
+    bool outermost = g_xmlPlansBuilding.empty();
+    auto building = make_unique<XmlStructPlan>();
+    XmlStructPlan * plan = building.get();
+    plan->hash = key;
+    g_xmlPlansBuilding[key] = das::move(building);
+    for ( uint32_t i=0; i!=si->count; ++i ) {
+        VarInfo * vi = si->fields[i];
+        XmlFieldPlan fp;
+        fp.name = vi->name;
+        fp.offset = vi->offset;
+        fp.type = vi->type;
+        fp.stride = 0;
+        fp.plan = nullptr;
+        if ( vi->dimSize==0 && vi->type==Type::tStructure ) {
+            fp.kind = XmlFieldKind::structure;
+            fp.plan = xml_struct_plan(vi->structType, context, at);
+        } else if ( vi->dimSize==0 && vi->type==Type::tArray && vi->firstType->dimSize==0
+                && (vi->firstType->type==Type::tStructure || xml_is_value_type(vi->firstType->type)) ) {
+            bool isStruct = vi->firstType->type==Type::tStructure;
+            fp.kind = isStruct ? XmlFieldKind::array_of_structures : XmlFieldKind::array_of_values;
+            fp.type = vi->firstType->type;
+            fp.stride = vi->firstType->size;
+            fp.plan = isStruct ? xml_struct_plan(vi->firstType->structType, context, at) : nullptr;
+        } else if ( vi->dimSize==0 && xml_is_value_type(vi->type) ) {
+            fp.kind = XmlFieldKind::value;
+        } else {
+            string typeName = debug_type(vi);
+            // this plan, and every plan which contains it, is incomplete
+            g_xmlPlansBuilding.clear();
+            context.throw_error_at(at, "xml_to_struct: field %s.%s of type %s is not supported",
+                si->name, vi->name, typeName.c_str());
+        }
+        plan->index[hash_blockz64((const uint8_t *)vi->name)] = int32_t(plan->fields.size());
+        plan->fields.emplace_back(fp);
+    }
+    if ( outermost ) {
+        for ( auto & kv : g_xmlPlansBuilding ) {
+            g_xmlPlans[kv.first] = das::move(kv.second);
+        }
+        g_xmlPlansBuilding.clear();
+    }
+    return plan;
+}
+
+static const XmlFieldPlan * xml_find_field ( const XmlStructPlan * plan, const char * name ) {
+    auto it = plan->index.find(hash_blockz64((const uint8_t *)name));
+    if ( it==plan->index.end() ) return nullptr;
+    auto & fp = plan->fields[it->second];
+    return fp.name==name ? &fp : nullptr;
+}
+
+// V is either xml_attribute or xml_text, both have the same as_xxx conversions
+template <typename V>
+static void xml_assign ( Type type, char * data, const V & v, Context & context, LineInfo * at ) {
+    switch ( type ) {
+    case Type::tBool:   *(bool *)data = v.as_bool(); break;
+    case Type::tInt8:   *(int8_t *)data = int8_t(v.as_int()); break;
+    case Type::tUInt8:  *(uint8_t *)data = uint8_t(v.as_uint()); break;
+    case Type::tInt16:  *(int16_t *)data = int16_t(v.as_int()); break;
+    case Type::tUInt16: *(uint16_t *)data = uint16_t(v.as_uint()); break;
+    case Type::tInt:    *(int32_t *)data = v.as_int(); break;
+    case Type::tUInt:   *(uint32_t *)data = v.as_uint(); break;
+    case Type::tInt64:  *(int64_t *)data = v.as_llong(); break;
+    case Type::tUInt64: *(uint64_t *)data = v.as_ullong(); break;
+    case Type::tFloat:  *(float *)data = v.as_float(); break;
+    case Type::tDouble: *(double *)data = v.as_double(); break;
+    case Type::tString: {
+            auto str = v.as_string();
+            *(char **)data = *str ? context.allocateString(str, uint32_t(strlen(str)), at) : nullptr;
+        }
+        break;
+    default: DAS_ASSERTF(0, "unsupported value type");
+    }
+}
+
+static char * xml_push_element ( Array & arr, uint32_t stride, Context & context, LineInfo * at ) {
+    uint32_t index = arr.size;
+    array_resize(context, arr, index + 1, stride, true, at);
+    return arr.data + index*stride;
+}
+
+static void xml_fill_struct ( const pugi::xml_node & node, const XmlStructPlan * plan, char * data, Context & context, LineInfo * at ) {
+    for ( auto attr : node.attributes() ) {
+        auto fp = xml_find_field(plan, attr.name());
+        if ( fp && fp->kind==XmlFieldKind::value ) {
+            xml_assign(fp->type, data + fp->offset, attr, context, at);
+        }
+    }
+    for ( auto child : node.children() ) {
+        if ( child.type()!=pugi::node_element ) continue;
+        auto fp = xml_find_field(plan, child.name());
+        if ( !fp ) continue;
+        char * fdata = data + fp->offset;
+        switch ( fp->kind ) {
+        case XmlFieldKind::value:
+            xml_assign(fp->type, fdata, child.text(), context, at);
+            break;
+        case XmlFieldKind::structure:
+            xml_fill_struct(child, fp->plan, fdata, context, at);
+            break;
+        case XmlFieldKind::array_of_values:
+            xml_assign(fp->type, xml_push_element(*(Array *)fdata, fp->stride, context, at), child.text(), context, at);
+            break;
+        case XmlFieldKind::array_of_structures:
+            xml_fill_struct(child, fp->plan, xml_push_element(*(Array *)fdata, fp->stride, context, at), context, at);
+            break;
+        }
+    }
+}
+
+vec4f pugiXmlToStruct ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+    auto node = cast<pugi::xml_node *>::to(args[0]);
+    auto data = cast<char *>::to(args[1]);
+    TypeInfo * ti = call->types[1];
+    if ( ti->type!=Type::tStructure || ti->dimSize ) {
+        context.throw_error_at(call->debugInfo, "xml_to_struct: expecting structure, got %s", debug_type(ti).c_str());
+    }
+    auto plan = xml_struct_plan(ti->structType, context, &call->debugInfo);
+    xml_fill_struct(*node, plan, data, context, &call->debugInfo);
+    return v_zero();
+}
+
+vec4f pugiXmlToArray ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+    auto node = cast<pugi::xml_node *>::to(args[0]);
+    auto name = cast<char *>::to(args[1]);
+    auto arr = cast<Array *>::to(args[2]);
+    TypeInfo * ti = call->types[2];
+    if ( ti->type!=Type::tArray || !ti->firstType || ti->firstType->dimSize
+            || (ti->firstType->type!=Type::tStructure && !xml_is_value_type(ti->firstType->type)) ) {
+        context.throw_error_at(call->debugInfo, "xml_to_array: expecting array of structures or values, got %s", debug_type(ti).c_str());
+    }
+    TypeInfo * eti = ti->firstType;
+    auto plan = eti->type==Type::tStructure ? xml_struct_plan(eti->structType, context, &call->debugInfo) : nullptr;
+    for ( auto child : node->children(name ? name : "") ) {
+        if ( child.type()!=pugi::node_element ) continue;
+        char * edata = xml_push_element(*arr, eti->size, context, &call->debugInfo);
+        if ( plan ) {
+            xml_fill_struct(child, plan, edata, context, &call->debugInfo);
+        } else {
+            xml_assign(eti->type, edata, child.text(), context, &call->debugInfo);
+        }
+    }
+    return v_zero();
+}
+
 class Module_PUGIXML : public Module {
 public:
     Module_PUGIXML() : Module("pugixml") {
@@ -243,6 +454,13 @@ public:
         addExtern<DAS_BIND_FUN(pugiAttribute_as_bool)> (*this, lib, "as_bool",
             SideEffects::none, "pugiAttribute_as_bool")
                 ->args({"attribute","default_value"});
+        // xml to struct
+        addInterop<pugiXmlToStruct,void,const pugi::xml_node &,vec4f> (*this, lib, "xml_to_struct",
+            SideEffects::modifyArgumentAndExternal, "pugiXmlToStruct")
+                ->args({"node","value"});
+        addInterop<pugiXmlToArray,void,const pugi::xml_node &,char *,vec4f> (*this, lib, "xml_to_array",
+            SideEffects::modifyArgumentAndExternal, "pugiXmlToArray")
+                ->args({"node","name","value"});
     }
     virtual ModuleAotType aotRequire ( TextWriter & tw ) const override {
         tw << "#include \"../modules/dasPUGIXML/src/dasPUGIXML.h\"\n";
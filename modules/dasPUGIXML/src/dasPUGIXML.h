@@ -22,4 +22,7 @@ namespace das {
     double pugiAttribute_as_double ( const pugi::xml_attribute & attr, double def );
     float pugiAttribute_as_float ( const pugi::xml_attribute & attr, float def );
     bool pugiAttribute_as_bool ( const pugi::xml_attribute & attr, bool def );
+    // xml to struct
+    vec4f pugiXmlToStruct ( Context & context, SimNode_CallBase * call, vec4f * args );
+    vec4f pugiXmlToArray ( Context & context, SimNode_CallBase * call, vec4f * args );
 }
@@ -10,4 +10,8 @@ namespace das {
             Context * context, LineInfoArg * at );
     int sqlite3_bind_blob_ ( sqlite3_stmt * stmt, int index, void * data, int size );
     int sqlite3_bind_text_ ( sqlite3_stmt * stmt, int index, const char * data );
+    vec4f sqlite3_rows_plan ( Context & context, SimNode_CallBase * call, vec4f * args );
+    vec4f sqlite3_bind_plan ( Context & context, SimNode_CallBase * call, vec4f * args );
+    vec4f sqlite3_fetch_rows ( Context & context, SimNode_CallBase * call, vec4f * args );
+    vec4f sqlite3_execute_rows ( Context & context, SimNode_CallBase * call, vec4f * args );
 }
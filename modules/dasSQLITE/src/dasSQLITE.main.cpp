@@ -69,6 +69,182 @@ int sqlite3_bind_text_ ( sqlite3_stmt * stmt, int index, const char * data ) {
     return sqlite3_bind_text(stmt, index, data, -1, SQLITE_TRANSIENT);
 }
 
+// typed rows: plan maps columns (or parameters) onto structure fields, computed once per statement
+
+static StructInfo * rows_struct_info ( TypeInfo * ti, Context & context, SimNode_CallBase * call ) {
+    if ( ti->type!=Type::tArray || !ti->firstType || ti->firstType->type!=Type::tStructure ) {
+        context.throw_error_at(call->debugInfo, "expecting array of structures");
+    }
+    return ti->firstType->structType;
+}
+
+static bool is_supported_field ( VarInfo * vi ) {
+    if ( vi->dimSize ) return false;
+    switch ( vi->type ) {
+    case Type::tBool:
+    case Type::tInt8:   case Type::tUInt8:
+    case Type::tInt16:  case Type::tUInt16:
+    case Type::tInt:    case Type::tUInt:
+    case Type::tInt64:  case Type::tUInt64:
+    case Type::tFloat:  case Type::tDouble:
+    case Type::tString:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static int32_t find_field ( StructInfo * si, const char * name, Context & context, SimNode_CallBase * call ) {
+    if ( !name ) return -1;
+    for ( uint32_t i=0; i!=si->count; ++i ) {
+        VarInfo * vi = si->fields[i];
+        if ( strcmp(vi->name, name)==0 ) {
+            if ( !is_supported_field(vi) ) {
+                context.throw_error_at(call->debugInfo, "field %s.%s has unsupported type %s",
+                    si->name, vi->name, debug_type(vi).c_str());
+            }
+            return int32_t(i);
+        }
+    }
+    return -1;
+}
+
+vec4f sqlite3_rows_plan ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+    auto stmt = cast<sqlite3_stmt *>::to(args[0]);
+    auto plan = cast<Array *>::to(args[1]);
+    auto si = rows_struct_info(call->types[2], context, call);
+    if ( !stmt ) context.throw_error_at(call->debugInfo, "statement is null");
+    int32_t ncol = sqlite3_column_count(stmt);
+    array_resize(context, *plan, ncol, sizeof(int32_t), false, &call->debugInfo);
+    int32_t * fi = (int32_t *) plan->data;
+    for ( int32_t col=0; col!=ncol; ++col ) {
+        fi[col] = find_field(si, sqlite3_column_name(stmt, col), context, call);
+    }
+    return v_zero();
+}
+
+vec4f sqlite3_bind_plan ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+    auto stmt = cast<sqlite3_stmt *>::to(args[0]);
+    auto plan = cast<Array *>::to(args[1]);
+    auto si = rows_struct_info(call->types[2], context, call);
+    if ( !stmt ) context.throw_error_at(call->debugInfo, "statement is null");
+    int32_t npar = sqlite3_bind_parameter_count(stmt);
+    array_resize(context, *plan, npar, sizeof(int32_t), false, &call->debugInfo);
+    int32_t * fi = (int32_t *) plan->data;
+    for ( int32_t par=0; par!=npar; ++par ) {
+        const char * name = sqlite3_bind_parameter_name(stmt, par + 1);
+        if ( name && name[0]!='?' ) {
+            fi[par] = find_field(si, name + 1, context, call);     // skip :, @, or $
+        } else if ( uint32_t(par) < si->count ) {
+            fi[par] = find_field(si, si->fields[par]->name, context, call);
+        } else {
+            fi[par] = -1;
+        }
+    }
+    return v_zero();
+}
+
+static void read_column ( sqlite3_stmt * stmt, int32_t col, VarInfo * vi, char * row, Context & context, LineInfo * at ) {
+    char * data = row + vi->offset;
+    switch ( vi->type ) {
+    case Type::tBool:   *(bool *)data = sqlite3_column_int(stmt, col)!=0; break;
+    case Type::tInt8:   *(int8_t *)data = int8_t(sqlite3_column_int(stmt, col)); break;
+    case Type::tUInt8:  *(uint8_t *)data = uint8_t(sqlite3_column_int(stmt, col)); break;
+    case Type::tInt16:  *(int16_t *)data = int16_t(sqlite3_column_int(stmt, col)); break;
+    case Type::tUInt16: *(uint16_t *)data = uint16_t(sqlite3_column_int(stmt, col)); break;
+    case Type::tInt:    *(int32_t *)data = sqlite3_column_int(stmt, col); break;
+    case Type::tUInt:   *(uint32_t *)data = uint32_t(sqlite3_column_int64(stmt, col)); break;
+    case Type::tInt64:  *(int64_t *)data = sqlite3_column_int64(stmt, col); break;
+    case Type::tUInt64: *(uint64_t *)data = uint64_t(sqlite3_column_int64(stmt, col)); break;
+    case Type::tFloat:  *(float *)data = float(sqlite3_column_double(stmt, col)); break;
+    case Type::tDouble: *(double *)data = sqlite3_column_double(stmt, col); break;
+    case Type::tString: {
+            auto text = (const char *) sqlite3_column_text(stmt, col);
+            auto len = sqlite3_column_bytes(stmt, col);
+            *(char **)data = (text && len) ? context.allocateString(text, uint32_t(len), at) : nullptr;
+        }
+        break;
+    default: DAS_ASSERTF(0, "unsupported field type");
+    }
+}
+
+vec4f sqlite3_fetch_rows ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+    auto stmt = cast<sqlite3_stmt *>::to(args[0]);
+    auto plan = cast<Array *>::to(args[1]);
+    auto rows = cast<Array *>::to(args[2]);
+    auto maxRows = cast<int32_t>::to(args[3]);
+    auto si = rows_struct_info(call->types[2], context, call);
+    if ( !stmt ) context.throw_error_at(call->debugInfo, "statement is null");
+    int32_t ncol = das::min(int32_t(plan->size), sqlite3_column_count(stmt));
+    int32_t * fi = (int32_t *) plan->data;
+    uint32_t stride = si->size;
+    int rc = SQLITE_ROW;
+    for ( int32_t n=0; n!=maxRows; ++n ) {
+        rc = sqlite3_step(stmt);
+        if ( rc!=SQLITE_ROW ) break;
+        uint32_t index = rows->size;
+        array_resize(context, *rows, index + 1, stride, true, &call->debugInfo);
+        char * row = rows->data + index*stride;
+        for ( int32_t col=0; col!=ncol; ++col ) {
+            if ( fi[col]>=0 ) {
+                read_column(stmt, col, si->fields[fi[col]], row, context, &call->debugInfo);
+            }
+        }
+    }
+    return cast<int32_t>::from(rc);
+}
+
+static int bind_field ( sqlite3_stmt * stmt, int32_t par, VarInfo * vi, const char * row ) {
+    const char * data = row + vi->offset;
+    switch ( vi->type ) {
+    case Type::tBool:   return sqlite3_bind_int(stmt, par, *(bool *)data ? 1 : 0);
+    case Type::tInt8:   return sqlite3_bind_int(stmt, par, *(int8_t *)data);
+    case Type::tUInt8:  return sqlite3_bind_int(stmt, par, *(uint8_t *)data);
+    case Type::tInt16:  return sqlite3_bind_int(stmt, par, *(int16_t *)data);
+    case Type::tUInt16: return sqlite3_bind_int(stmt, par, *(uint16_t *)data);
+    case Type::tInt:    return sqlite3_bind_int(stmt, par, *(int32_t *)data);
+    case Type::tUInt:   return sqlite3_bind_int64(stmt, par, *(uint32_t *)data);
+    case Type::tInt64:  return sqlite3_bind_int64(stmt, par, *(int64_t *)data);
+    case Type::tUInt64: return sqlite3_bind_int64(stmt, par, sqlite3_int64(*(uint64_t *)data));
+    case Type::tFloat:  return sqlite3_bind_double(stmt, par, *(float *)data);
+    case Type::tDouble: return sqlite3_bind_double(stmt, par, *(double *)data);
+    case Type::tString: {
+            auto str = *(const char **)data;
+            // bindings are cleared before the row data can go away, so there is no need to copy
+            return sqlite3_bind_text(stmt, par, str ? str : "", -1, SQLITE_STATIC);
+        }
+    default: DAS_ASSERTF(0, "unsupported field type"); return SQLITE_MISUSE;
+    }
+}
+
+vec4f sqlite3_execute_rows ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+    auto stmt = cast<sqlite3_stmt *>::to(args[0]);
+    auto plan = cast<Array *>::to(args[1]);
+    auto rows = cast<Array *>::to(args[2]);
+    auto si = rows_struct_info(call->types[2], context, call);
+    if ( !stmt ) context.throw_error_at(call->debugInfo, "statement is null");
+    int32_t npar = int32_t(plan->size);
+    int32_t * fi = (int32_t *) plan->data;
+    uint32_t stride = si->size;
+    int rc = SQLITE_OK;
+    for ( uint32_t index=0; index!=rows->size && rc==SQLITE_OK; ++index ) {
+        const char * row = rows->data + index*stride;
+        sqlite3_reset(stmt);
+        for ( int32_t par=0; par!=npar && rc==SQLITE_OK; ++par ) {
+            if ( fi[par]>=0 ) {
+                rc = bind_field(stmt, par + 1, si->fields[fi[par]], row);
+            }
+        }
+        if ( rc==SQLITE_OK ) {
+            rc = sqlite3_step(stmt);
+            if ( rc==SQLITE_DONE || rc==SQLITE_ROW ) rc = SQLITE_OK;
+        }
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return cast<int32_t>::from(rc);
+}
+
 void Module_dasSQLITE::initMain() {
 
     addExtern<DAS_BIND_FUN(sqlite3_exec)>(*this,lib,"sqlite3_exec",
@@ -83,6 +259,19 @@ void Module_dasSQLITE::initMain() {
     addExtern<DAS_BIND_FUN(sqlite3_bind_text_)>(*this,lib,"sqlite3_bind_text",
         SideEffects::worstDefault, "sqlite3_bind_text_")
             ->args({"stmt","index","data"});
+    // typed rows
+    addInterop<sqlite3_rows_plan,void,sqlite3_stmt *,TArray<int32_t> &,vec4f>(*this,lib,"_builtin_sqlite3_rows_plan",
+        SideEffects::modifyArgumentAndExternal, "sqlite3_rows_plan")
+            ->args({"stmt","plan","rows"});
+    addInterop<sqlite3_bind_plan,void,sqlite3_stmt *,TArray<int32_t> &,vec4f>(*this,lib,"_builtin_sqlite3_bind_plan",
+        SideEffects::modifyArgumentAndExternal, "sqlite3_bind_plan")
+            ->args({"stmt","plan","rows"});
+    addInterop<sqlite3_fetch_rows,int32_t,sqlite3_stmt *,const TArray<int32_t> &,vec4f,int32_t>(*this,lib,"_builtin_sqlite3_fetch_rows",
+        SideEffects::modifyArgumentAndExternal, "sqlite3_fetch_rows")
+            ->args({"stmt","plan","rows","max_rows"});
+    addInterop<sqlite3_execute_rows,int32_t,sqlite3_stmt *,const TArray<int32_t> &,vec4f>(*this,lib,"_builtin_sqlite3_execute_rows",
+        SideEffects::modifyExternal, "sqlite3_execute_rows")
+            ->args({"stmt","plan","rows"});
 
     for ( auto & pfn : this->functions.each() ) {
         // ok, lets fix up everything returning uint8? into returning string# and make it unsafe operation
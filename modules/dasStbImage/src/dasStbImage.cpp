@@ -3,11 +3,67 @@
 #include "daScript/ast/ast.h"
 #include "daScript/ast/ast_interop.h"
 #include "daScript/ast/ast_typefactory_bind.h"
+#include "daScript/misc/job_que.h"
+#include "daScript/misc/performance_time.h"
+
+#include <sys/stat.h>
+
+#if _WIN32
+    // provided by the fio module
+    #define PROT_READ  1
+    #define MAP_FAILED ((void*)-1)
+    #define MAP_SHARED  0x01
+    void* mmap(void* start, size_t length, int prot, int flags, int fd, off_t offset);
+    int munmap(void* start, size_t length);
+#else
+    #include <sys/mman.h>
+#endif
+
+namespace das {
+    // stbi_load_batch decodes straight into the das array when stb happens to allocate
+    // the final image buffer of exactly the expected size (jpeg asks for one extra byte)
+    static DAS_THREAD_LOCAL uint8_t * g_stbiTarget = nullptr;
+    static DAS_THREAD_LOCAL size_t g_stbiTargetSize = 0;
+    static DAS_THREAD_LOCAL bool g_stbiTargetTaken = false;
+
+    void * stbi_das_malloc ( size_t size ) {
+        if ( g_stbiTarget && !g_stbiTargetTaken && (size==g_stbiTargetSize || size==g_stbiTargetSize+1) ) {
+            g_stbiTargetTaken = true;
+            return g_stbiTarget;
+        }
+        return malloc(size);
+    }
+
+    void stbi_das_free ( void * ptr ) {
+        if ( ptr && ptr==g_stbiTarget ) {
+            g_stbiTargetTaken = false;
+        } else {
+            free(ptr);
+        }
+    }
+
+    void * stbi_das_realloc ( void * ptr, size_t size ) {
+        if ( !ptr ) return stbi_das_malloc(size);
+        if ( ptr==g_stbiTarget ) {
+            // the target never grows, move out of it
+            void * res = malloc(size);
+            if ( res ) {
+                memcpy(res, ptr, size < g_stbiTargetSize ? size : g_stbiTargetSize);
+                g_stbiTargetTaken = false;
+            }
+            return res;
+        }
+        return realloc(ptr, size);
+    }
+}
 
 #ifdef STB_IMPLEMENTATION_ALREADY_LINKED
     #include "stb_image.h"
     #include "stb_image_write.h"
 #else
+    #define STBI_MALLOC(sz)         das::stbi_das_malloc(sz)
+    #define STBI_REALLOC(p,newsz)   das::stbi_das_realloc(p,newsz)
+    #define STBI_FREE(p)            das::stbi_das_free(p)
     #define STB_IMAGE_IMPLEMENTATION
     #include "stb_image.h"
     #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -16,6 +72,170 @@
 
 namespace das {
 
+extern mutex              g_jobQueMutex;
+extern shared_ptr<JobQue> g_jobQue;
+
+struct StbiBatchItem {
+    FILE *      file = nullptr;
+    void *      mapped = nullptr;
+    size_t      mappedSize = 0;
+    int32_t     width = 0;
+    int32_t     height = 0;
+    int32_t     channels = 0;
+    uint8_t *   pixels = nullptr;
+    size_t      size = 0;
+    int32_t     usec = 0;
+    const char * error = nullptr;
+};
+
+struct StbiImageLayout {
+    uint32_t    width, height, channels, pixels, decode_time_usec, error;
+};
+
+static uint32_t stbi_image_field ( StructInfo * si, const char * name, Type type, Context & context, LineInfo * at ) {
+    for ( uint32_t i=0; i!=si->count; ++i ) {
+        VarInfo * vi = si->fields[i];
+        if ( strcmp(vi->name, name)!=0 ) continue;
+        bool ok = vi->dimSize==0 && vi->type==type;
+        if ( ok && type==Type::tArray ) ok = vi->firstType->type==Type::tUInt8 && vi->firstType->dimSize==0;
+        if ( !ok ) context.throw_error_at(at, "stbi_load_batch: unexpected type of %s.%s", si->name, name);
+        return vi->offset;
+    }
+    context.throw_error_at(at, "stbi_load_batch: %s does not have field %s", si->name, name);
+    return 0;
+}
+
+static void stbi_decode_item ( StbiBatchItem & item, int32_t req_comp ) {
+    auto t0 = ref_time_ticks();
+    int32_t w = 0, h = 0, comp = 0;
+#ifndef STB_IMPLEMENTATION_ALREADY_LINKED
+    g_stbiTarget = item.pixels;
+    g_stbiTargetSize = item.size;
+    g_stbiTargetTaken = false;
+#endif
+    uint8_t * res = item.mapped ?
+        stbi_load_from_memory((const stbi_uc *)item.mapped, int(item.mappedSize), &w, &h, &comp, req_comp) :
+        stbi_load_from_file(item.file, &w, &h, &comp, req_comp);
+#ifndef STB_IMPLEMENTATION_ALREADY_LINKED
+    g_stbiTarget = nullptr;
+    g_stbiTargetTaken = false;
+#endif
+    if ( !res ) {
+        item.error = stbi_failure_reason();
+    } else if ( w!=item.width || h!=item.height ) {
+        item.error = "image size does not match its header";
+        if ( res!=item.pixels ) stbi_image_free(res);
+    } else if ( res!=item.pixels ) {
+        memcpy(item.pixels, res, item.size);
+        stbi_image_free(res);
+    }
+    item.usec = get_time_usec(t0);
+}
+
+// stbi_load_batch(files, out, req_comp, use_mmap) : int
+// headers are read and pixel arrays are allocated on the calling thread, images are decoded on the job queue
+vec4f stbiLoadBatch ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+    auto files = cast<TArray<char *> *>::to(args[0]);
+    auto out = cast<Array *>::to(args[1]);
+    int32_t req_comp = cast<int32_t>::to(args[2]);
+    bool use_mmap = cast<bool>::to(args[3]);
+    auto at = &call->debugInfo;
+    TypeInfo * ti = call->types[1];
+    if ( ti->type!=Type::tArray || !ti->firstType || ti->firstType->type!=Type::tStructure || ti->firstType->dimSize ) {
+        context.throw_error_at(at, "stbi_load_batch: expecting array of Image, got %s", debug_type(ti).c_str());
+    }
+    if ( req_comp<0 || req_comp>4 ) context.throw_error_at(at, "stbi_load_batch: req_comp %i is out of range", req_comp);
+    StructInfo * si = ti->firstType->structType;
+    StbiImageLayout layout;
+    layout.width = stbi_image_field(si, "width", Type::tInt, context, at);
+    layout.height = stbi_image_field(si, "height", Type::tInt, context, at);
+    layout.channels = stbi_image_field(si, "channels", Type::tInt, context, at);
+    layout.pixels = stbi_image_field(si, "pixels", Type::tArray, context, at);
+    layout.decode_time_usec = stbi_image_field(si, "decode_time_usec", Type::tInt, context, at);
+    layout.error = stbi_image_field(si, "error", Type::tString, context, at);
+    uint32_t total = files->size;
+    if ( out->size!=total ) context.throw_error_at(at, "stbi_load_batch: expecting %u images, got %u", total, out->size);
+    vector<StbiBatchItem> items(total);
+    for ( uint32_t i=0; i!=total; ++i ) {
+        auto & item = items[i];
+        const char * fname = (*files)[i];
+        item.file = fname ? fopen(fname, "rb") : nullptr;
+        if ( !item.file ) {
+            item.error = "can't open file";
+            continue;
+        }
+        int32_t comp = 0;
+        int ok = 0;
+        if ( use_mmap ) {
+            struct stat st;
+            int fd = fileno(item.file);
+            if ( fstat(fd, &st)==0 && st.st_size>0 ) {
+                void * data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+                if ( data!=MAP_FAILED ) {
+                    item.mapped = data;
+                    item.mappedSize = size_t(st.st_size);
+                }
+            }
+            if ( item.mapped ) ok = stbi_info_from_memory((const stbi_uc *)item.mapped, int(item.mappedSize), &item.width, &item.height, &comp);
+            else item.error = "can't map file";
+        } else {
+            ok = stbi_info_from_file(item.file, &item.width, &item.height, &comp);
+        }
+        if ( !ok ) {
+            if ( !item.error ) item.error = stbi_failure_reason();
+            continue;
+        }
+        item.channels = req_comp ? req_comp : comp;
+        item.size = size_t(item.width) * size_t(item.height) * size_t(item.channels);
+        if ( item.size > 0x7fffffff ) {
+            item.error = "image is too large";
+            continue;
+        }
+        char * image = out->data + size_t(i) * ti->firstType->size;
+        auto & pixels = *(Array *)(image + layout.pixels);
+        // one extra byte, so that jpeg decodes in place
+        array_reserve(context, pixels, uint32_t(item.size) + 1, 1, at);
+        array_resize(context, pixels, uint32_t(item.size), 1, false, at);
+        item.pixels = (uint8_t *) pixels.data;
+    }
+    auto decode = [&]( int from, int to ) {
+        for ( int i=from; i<to && i<int(total); ++i ) {
+            if ( items[i].pixels ) stbi_decode_item(items[i], req_comp);
+        }
+    };
+    shared_ptr<JobQue> jq;
+    {
+        lock_guard<mutex> guard(g_jobQueMutex);
+        jq = g_jobQue;
+    }
+    if ( total>1 ) {
+        if ( !jq ) jq = make_shared<JobQue>();
+        jq->parallel_for(0, int(total), decode, 0, JobPriority::Default, int(total));
+    } else {
+        decode(0, int(total));
+    }
+    int32_t decoded = 0;
+    for ( uint32_t i=0; i!=total; ++i ) {
+        auto & item = items[i];
+        if ( item.mapped ) munmap(item.mapped, item.mappedSize);
+        if ( item.file ) fclose(item.file);
+        char * image = out->data + size_t(i) * ti->firstType->size;
+        auto & pixels = *(Array *)(image + layout.pixels);
+        if ( item.error ) {
+            if ( item.pixels ) array_resize(context, pixels, 0, 1, false, at);
+            *(char **)(image + layout.error) = context.allocateString(item.error, uint32_t(strlen(item.error)), at);
+            item.width = item.height = item.channels = 0;
+        } else {
+            decoded ++;
+        }
+        *(int32_t *)(image + layout.width) = item.width;
+        *(int32_t *)(image + layout.height) = item.height;
+        *(int32_t *)(image + layout.channels) = item.channels;
+        *(int32_t *)(image + layout.decode_time_usec) = item.usec;
+    }
+    return cast<int32_t>::from(decoded);
+}
+
 class Module_StbImage : public Module {
 public:
     Module_StbImage() : Module("stbimage") {
@@ -48,6 +268,9 @@ public:
         addExtern<DAS_BIND_FUN(stbi_write_hdr)> (*this, lib, "stbi_write_hdr",
             SideEffects::worstDefault, "stbi_write_hdr")
                 ->args({"filename","x","y","comp","data"});;
+        addInterop<stbiLoadBatch,int32_t,const TArray<char *> &,vec4f,int32_t,bool> (*this, lib, "_builtin_stbi_load_batch",
+            SideEffects::modifyArgumentAndExternal, "stbiLoadBatch")
+                ->args({"files","out","req_comp","use_mmap"});
     }
     virtual ModuleAotType aotRequire ( TextWriter & tw ) const override {
         tw << "#include \"../modules/dasStbImage/src/dasStbImage.h\"\n";
@@ -2,4 +2,8 @@
 
 
 #include "stb_image.h"
-#include "stb_image_write.h"
\ No newline at end of file
+#include "stb_image_write.h"
+
+namespace das {
+    vec4f stbiLoadBatch ( Context & context, SimNode_CallBase * call, vec4f * args );
+}
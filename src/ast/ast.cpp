@@ -60,8 +60,18 @@ namespace das {
         return *g_AOT_lib;
     }
 
+    DAS_THREAD_LOCAL unique_ptr<AotColdSet> g_AOT_cold;
+
     void clearGlobalAotLibrary() {
         g_AOT_lib.reset();
+        g_AOT_cold.reset();
+    }
+
+    AotColdSet & getGlobalAotColdSet() {
+        if ( !g_AOT_cold ) {
+            g_AOT_cold = make_unique<AotColdSet>();
+        }
+        return *g_AOT_cold;
     }
 
     // annotations
@@ -1480,6 +1490,7 @@ namespace das {
         ExprLooksLikeCall::clone(cexpr);
         cexpr->typeexpr = typeexpr;
         cexpr->initializer = initializer;
+        cexpr->onStack = onStack;
         return cexpr;
     }
 
@@ -3078,6 +3089,14 @@ namespace das {
         return policies.debugger || options.getBoolOption("debugger",false);
     }
 
+    bool Program::getDebuggerPatching() const {
+        return getDebugger() && (policies.debugger_patching || options.getBoolOption("debugger_patching",false));
+    }
+
+    bool Program::getDebugNodes() const {
+        return getDebugger() && !getDebuggerPatching();
+    }
+
     bool Program::getProfiler() const {
         return policies.profiler || options.getBoolOption("profiler",false);
     }
@@ -3090,6 +3109,15 @@ namespace das {
         if (log) {
             logs << *this << "\n";
         }
+        // devirtualization and inlining go first, while the code is not folded yet
+        if ( optimizationDevirtualization(logs) ) {
+            if ( log ) logs << "DEVIRTUALIZATION: optimized\n"; if ( logPass ) logs << *this;
+        }
+        if ( failed() ) return;
+        if ( optimizationInlining(logs) ) {
+            if ( log ) logs << "INLINING: optimized\n"; if ( logPass ) logs << *this;
+        }
+        if ( failed() ) return;
         do {
             if ( log ) logs << "OPTIMIZE:\n"; if ( logPass ) logs << *this;
             any = false;
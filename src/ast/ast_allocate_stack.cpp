@@ -431,7 +431,18 @@ namespace das {
         virtual void preVisit ( ExprAscend * expr ) override {
             Visitor::preVisit(expr);
             if ( inStruct ) return;
-            if ( expr->subexpr->rtti_isMakeLocal() ) {
+            if ( expr->onStack ) {
+                uint32_t sz = expr->subexpr->type->getSizeOf();
+                expr->stackTop = allocateStack(sz);
+                expr->useStackRef = false;
+                if ( log ) {
+                    logs << "\t" << expr->stackTop << "\t" << sz
+                    << "\tascend on the stack, line " << expr->at.line << "\n";
+                }
+                auto mkl = static_pointer_cast<ExprMakeLocal>(expr->subexpr);
+                mkl->setRefSp(false, false, expr->stackTop, 0);
+                mkl->doesNotNeedInit = false;
+            } else if ( expr->subexpr->rtti_isMakeLocal() ) {
                 uint32_t sz = sizeof(void *);
                 expr->stackTop = allocateStack(sz);
                 expr->useStackRef = true;
@@ -511,7 +522,14 @@ namespace das {
         virtual void preVisit ( ExprNew * expr ) override {
             Visitor::preVisit(expr);
             if ( inStruct ) return;
-            if ( expr->type->dim.size() ) {
+            if ( expr->onStack ) {
+                auto sz = uint32_t(expr->type->firstType->getBaseSizeOf());
+                expr->stackTop = allocateStack(sz);
+                if ( log ) {
+                    logs << "\t" << expr->stackTop << "\t" << sz
+                    << "\tNEW " << expr->typeexpr->describe() << " on the stack, line " << expr->at.line << "\n";
+                }
+            } else if ( expr->type->dim.size() ) {
                 auto sz = uint32_t(expr->type->getCountOf()*sizeof(char *));
                 expr->stackTop = allocateStack(sz);
                 if ( log ) {
@@ -622,6 +640,10 @@ namespace das {
         // move some variables to CMRES
         VarCMRes vcm(this);
         visit(vcm);
+        // move allocations, which do not escape, to the stack
+        if ( getOptimize() ) {
+            markNonEscapingAllocations(logs);
+        }
         // allocate stack for the rest of them
         AllocateStack context(this, logs);
         visit(context);
@@ -1085,7 +1085,7 @@ namespace das {
             // functions
             ss << "\n";
             prog->thisModule->functions.foreach([&](auto fn){
-                if ( !fn->builtIn && !fn->noAot ) {
+                if ( !fn->builtIn && !fn->noAot && !fn->aotCold ) {
                     ss << describeCppFunc(fn.get(),&collector) << ";\n";
                 }
             });
@@ -1145,7 +1145,7 @@ namespace das {
         }
     // function
         virtual bool canVisitFunction ( Function * fun ) override {
-            if ( fun->noAot ) return false;
+            if ( fun->noAot || fun->aotCold ) return false;
             return true;
         }
         virtual void preVisit ( Function * fn) override {
@@ -3047,6 +3047,7 @@ namespace das {
             }
             if ( func->noAot ) return true;
             if ( func->aotHybrid ) return true;
+            if ( func->aotCold ) return true;
             if ( func->module == program->thisModule.get() ) return false;
             return true;
         }
@@ -3470,6 +3471,12 @@ namespace das {
                 continue;
             // SimFunction * fn = context.getFunction(i);
             uint64_t semH = fnn[i]->aotHash;
+            if ( fnn[i]->aotCold ) {
+                // cold function stays interpreted, the cold set tells linker its not missing
+                logs << "\t// " << aotFuncName(fnn[i]) << " (cold, interpreted)\n";
+                logs << "\tgetGlobalAotColdSet().insert(0x" << HEX << semH << DEC << ");\n";
+                continue;
+            }
             logs << "\t// " << aotFuncName(fnn[i]) << "\n";
             logs << "\taotLib[0x" << HEX << semH << DEC << "] = [&](Context & ctx){\n\t\treturn ";
             logs << "ctx.code->makeNode<SimNode_Aot";
@@ -3513,6 +3520,9 @@ namespace das {
         logs << "        context.stringHeap = make_smart<LinearStringAllocator>();\n";
         logs << "    }\n";
         logs << "    context.heap->setInitialSize ( " << options.getIntOption("heap_size_hint", policies.heap_size_hint) << " /*options.getIntOption(\"heap_size_hint\", policies.heap_size_hint)*/);\n";
+        if ( auto nurserySize = options.getIntOption("heap_nursery_size", policies.heap_nursery_size) ) {
+            logs << "    context.heap = make_smart<NurseryHeapAllocator>(context.heap, " << nurserySize << ");\n";
+        }
         logs << "    context.stringHeap->setInitialSize ( " << options.getIntOption("string_heap_size_hint", policies.string_heap_size_hint) << " /*options.getIntOption(\"string_heap_size_hint\", policies.string_heap_size_hint)*/);\n";
         logs << "    context.constStringHeap = make_shared<ConstStringAllocator>();\n";
         logs << "    if ( " << globalStringHeapSize << " /*globalStringHeapSize*/) {\n";
@@ -3946,6 +3956,108 @@ namespace das {
         gen.run();
     }
 
+    bool loadAotProfile ( const string & fileName, AotProfile & profile, TextWriter & logs ) {
+        FILE * f = fopen(fileName.c_str(), "r");
+        if ( !f ) {
+            logs << "can't open AOT profile " << fileName << "\n";
+            return false;
+        }
+        // each line is 'mangled_name_hash calls time [mangled_name]', records for the same function are accumulated
+        //  mangled name can be longer than the buffer, only the numbers in front of it are read
+        char line[1024];
+        int lineNo = 0;
+        bool ok = true;
+        while ( fgets(line, sizeof(line), f) ) {
+            lineNo ++;
+            if ( !strchr(line, '\n') ) {
+                int c;
+                while ( (c = fgetc(f))!=EOF && c!='\n' ) {}
+            }
+            const char * ch = line;
+            while ( *ch==' ' || *ch=='\t' ) ch ++;
+            if ( *ch=='#' || *ch=='\n' || *ch=='\r' || *ch==0 ) continue;
+            char * end = nullptr;
+            uint64_t mnh = strtoull(ch, &end, 0);
+            if ( end==ch ) { ok = false; break; }
+            ch = end;
+            uint64_t calls = strtoull(ch, &end, 10);
+            if ( end==ch ) { ok = false; break; }
+            ch = end;
+            uint64_t time = strtoull(ch, &end, 10);
+            if ( end==ch ) { ok = false; break; }
+            auto & rec = profile[mnh];
+            rec.calls += calls;
+            rec.time += time;
+        }
+        fclose(f);
+        if ( !ok ) {
+            logs << "malformed AOT profile " << fileName << " at line " << lineNo << "\n";
+        }
+        return ok;
+    }
+
+    class AotExpressionCounter : public Visitor {
+    public:
+        virtual void preVisitExpression ( Expression * ) override { total ++; }
+        int total = 0;
+    };
+
+    void Program::markHotAot ( const AotProfile & profile, double coverage, int inlineSize, TextWriter & logs ) {
+        vector<pair<Function *,uint64_t>> candidates;
+        uint64_t totalTime = 0, moduleTime = 0;
+        for ( auto & it : profile ) {
+            totalTime += it.second.time;
+        }
+        thisModule->functions.foreach([&](auto pfun){
+            if ( pfun->index<0 || !pfun->used || pfun->builtIn || pfun->noAot ) return;
+            auto it = profile.find(pfun->getMangledNameHash());
+            uint64_t time = it!=profile.end() ? it->second.time : 0;
+            moduleTime += time;
+            candidates.emplace_back(pfun.get(), time);
+        });
+        stable_sort(candidates.begin(), candidates.end(), [](auto & a, auto & b){
+            return a.second > b.second;
+        });
+        // hottest functions, until we cover requested fraction of the module time
+        das_hash_set<Function *> hot;
+        vector<Function *> queue;
+        uint64_t hotTime = 0;
+        for ( auto & it : candidates ) {
+            if ( it.second==0 || hotTime>=uint64_t(coverage*double(moduleTime)) ) break;
+            hot.insert(it.first);
+            queue.push_back(it.first);
+            hotTime += it.second;
+        }
+        auto profiledHot = hot.size();
+        // small callees of the hot functions go in as well, so that C++ compiler can inline them
+        while ( !queue.empty() ) {
+            auto fn = queue.back();
+            queue.pop_back();
+            for ( auto callee : fn->useFunctions ) {
+                if ( callee->module!=thisModule.get() || callee->index<0 || !callee->used ) continue;
+                if ( callee->builtIn || callee->noAot || hot.find(callee)!=hot.end() ) continue;
+                AotExpressionCounter counter;
+                if ( callee->body ) callee->body->visit(counter);
+                if ( counter.total > inlineSize ) continue;
+                hot.insert(callee);
+                queue.push_back(callee);
+            }
+        }
+        uint64_t aotTime = 0;
+        for ( auto & it : candidates ) {
+            if ( hot.find(it.first)!=hot.end() ) {
+                aotTime += it.second;
+            } else {
+                it.first->aotCold = true;
+            }
+        }
+        auto percent = [](uint64_t a, uint64_t b) { return b ? double(a)*100.0/double(b) : 0.0; };
+        logs << "// profile guided AOT: " << uint64_t(hot.size()) << " of " << uint64_t(candidates.size())
+            << " functions compiled, " << uint64_t(hot.size()-profiledHot) << " of them as inlinable callees\n";
+        logs << "// expected coverage: " << percent(aotTime,moduleTime) << "% of module time, "
+            << percent(aotTime,totalTime) << "% of total profiled time\n";
+    }
+
     void Program::aotCpp ( Context & context, TextWriter & logs ) {
         // run no-aot marker
         NoAotMarker marker;
@@ -0,0 +1,314 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/ast/ast.h"
+#include "daScript/ast/ast_visitor.h"
+
+namespace das {
+
+    // Devirtualization of class method calls.
+    // Method is a function pointer field of the class instance, and a->method(args) is invoke(a.method, cast<auto> *a, args).
+    // The program is complete (it is not a module, which can be derived from later), so all classes are known.
+    // For every class we find all the functions, which its reachable code can store in the method field,
+    // i.e. initializers of [[Class ...]] and the default initializers of the field.
+    // If only one function can be stored in the field for the static class of 'a' and all the classes derived from it,
+    // the invoke is replaced with the direct call of that function.
+    // Any other write to the method field, or instance created without initializers (uninitialized local, array element, etc),
+    // disables devirtualization of that method.
+
+    static Structure * structOf ( const TypeDeclPtr & type ) {
+        if ( !type || !type->dim.empty() ) return nullptr;
+        if ( type->baseType==Type::tStructure ) return type->structType;
+        if ( type->baseType==Type::tPointer && type->firstType && type->firstType->baseType==Type::tStructure
+            && type->firstType->dim.empty() ) return type->firstType->structType;
+        return nullptr;
+    }
+
+    static bool isMethodField ( const Structure::FieldDeclaration & fd ) {
+        return fd.type && fd.type->baseType==Type::tFunction && fd.type->dim.empty();
+    }
+
+    // @@fn or cast<function<...>> @@fn
+    static Function * addressOf ( Expression * expr ) {
+        if ( !expr ) return nullptr;
+        if ( expr->rtti_isCast() ) expr = static_cast<ExprCast *>(expr)->subexpr.get();
+        if ( !expr->rtti_isAddr() ) return nullptr;
+        return static_cast<ExprAddr *>(expr)->func;
+    }
+
+    class DevirtualizeScan : public Visitor {
+    public:
+        das_hash_map<Structure *,das_hash_map<string,das_hash_set<Function *>>> targets;   // nullptr is 'unknown'
+        das_hash_set<Structure *>   uninitialized;
+        das_hash_set<string>        written;
+    protected:
+        vector<Expression *>        stack;
+        das_hash_set<Structure *>   walked;
+    protected:
+        virtual bool canVisitFunction ( Function * fun ) override {
+            return fun->used && !fun->builtIn;
+        }
+        virtual bool canVisitGlobalVariable ( Variable * var ) override {
+            return var->used;
+        }
+        virtual void preVisit ( Function * fun ) override {
+            Visitor::preVisit(fun);
+            stack.clear();
+        }
+        virtual void preVisitExpression ( Expression * expr ) override {
+            Visitor::preVisitExpression(expr);
+            if ( expr->rtti_isField() ) onField(static_cast<ExprField *>(expr));
+            if ( expr->type ) onContainer(expr->type.get());
+            stack.push_back(expr);
+        }
+        virtual ExpressionPtr visitExpression ( Expression * expr ) override {
+            if ( !stack.empty() && stack.back()==expr ) stack.pop_back();
+            return Visitor::visitExpression(expr);
+        }
+        virtual void preVisitLet ( ExprLet * expr, const VariablePtr & var, bool last ) override {
+            Visitor::preVisitLet(expr, var, last);
+            onVariable(var.get());
+        }
+        virtual void preVisitGlobalLet ( const VariablePtr & var ) override {
+            Visitor::preVisitGlobalLet(var);
+            onVariable(var.get());
+        }
+        virtual void preVisit ( ExprNew * expr ) override {
+            Visitor::preVisit(expr);
+            if ( !expr->initializer ) onUninitialized(expr->typeexpr.get());
+        }
+        virtual void preVisit ( ExprMakeStruct * expr ) override {
+            Visitor::preVisit(expr);
+            auto st = expr->makeType && expr->makeType->baseType==Type::tStructure ? expr->makeType->structType : nullptr;
+            if ( !st ) return;
+            if ( expr->structs.empty() ) {
+                onMakeStruct(expr, st, nullptr);
+            } else {
+                for ( auto & fields : expr->structs ) onMakeStruct(expr, st, fields.get());
+            }
+        }
+        void onMakeStruct ( ExprMakeStruct * expr, Structure * st, MakeStruct * fields ) {
+            for ( auto & fd : st->fields ) {
+                MakeFieldDecl * decl = nullptr;
+                if ( fields ) {
+                    for ( auto & mfd : *fields ) {
+                        if ( mfd->name==fd.name ) {
+                            decl = mfd.get();
+                            break;
+                        }
+                    }
+                }
+                Expression * init = decl ? decl->value.get() : (expr->useInitializer ? fd.init.get() : nullptr);
+                if ( st->isClass && isMethodField(fd) ) {
+                    targets[st][fd.name].insert(addressOf(init));
+                } else if ( !init ) {
+                    onUninitialized(fd.type.get());
+                }
+            }
+        }
+        void onVariable ( Variable * var ) {
+            if ( !var->type || var->type->ref ) return;
+            if ( var->init ) {
+                onContainer(var->type.get());
+            } else {
+                onUninitialized(var->type.get());
+            }
+        }
+        // anything, which can be resized or default constructed
+        void onContainer ( TypeDecl * type ) {
+            if ( !type->dim.empty() ) {
+                onUninitialized(type);
+            } else if ( type->baseType==Type::tArray || type->baseType==Type::tTable ) {
+                if ( type->firstType ) onUninitialized(type->firstType.get());
+                if ( type->secondType ) onUninitialized(type->secondType.get());
+            }
+        }
+        // all classes, which are contained in the type by value
+        void onUninitialized ( TypeDecl * type ) {
+            if ( !type ) return;
+            switch ( type->baseType ) {
+            case Type::tStructure:
+                if ( type->structType && walked.insert(type->structType).second ) {
+                    if ( type->structType->isClass ) uninitialized.insert(type->structType);
+                    for ( auto & fd : type->structType->fields ) onUninitialized(fd.type.get());
+                }
+                break;
+            case Type::tArray:
+            case Type::tTable:
+                onUninitialized(type->firstType.get());
+                onUninitialized(type->secondType.get());
+                break;
+            case Type::tTuple:
+            case Type::tVariant:
+                for ( auto & argT : type->argTypes ) onUninitialized(argT.get());
+                break;
+            default:
+                break;
+            }
+        }
+        void onField ( ExprField * expr ) {
+            if ( !expr->field || !isMethodField(*expr->field) ) return;
+            auto st = structOf(expr->value->type);
+            if ( !st || !st->isClass ) return;
+            if ( expr->r2v || isRead(expr) ) return;
+            written.insert(expr->name);
+        }
+        bool isRead ( ExprField * expr ) const {
+            if ( stack.empty() ) return false;
+            auto parent = stack.back();
+            if ( parent->rtti_isR2V() ) return true;
+            if ( parent->rtti_isInvoke() ) {
+                auto inv = static_cast<ExprInvoke *>(parent);
+                return !inv->arguments.empty() && inv->arguments[0].get()==expr;
+            }
+            return false;
+        }
+    };
+
+    class DevirtualizeCalls : public PassVisitor {
+    public:
+        DevirtualizeCalls ( TextWriter & l, DevirtualizeScan & s, Module * m, bool lg ) : logs(l), scan(s), thisModule(m), log(lg) {}
+        int32_t total = 0;
+        void collectHierarchy ( const ModuleLibrary & library ) {
+            library.foreach([&](Module * mod) -> bool {
+                mod->structures.foreach([&](auto & pst){
+                    if ( pst->isClass && pst->parent ) derived[pst->parent].push_back(pst.get());
+                });
+                return true;
+            }, "*");
+        }
+    protected:
+        TextWriter &                                    logs;
+        DevirtualizeScan &                              scan;
+        Module *                                        thisModule;
+        bool                                            log;
+        das_hash_map<Structure *,vector<Structure *>>   derived;
+    protected:
+        virtual bool canVisitFunction ( Function * fun ) override {
+            return !fun->builtIn;
+        }
+        // the only function, which can be stored in the method field of the class or any of its subclasses
+        Function * singleTarget ( Structure * st, const string & name ) {
+            Function * res = nullptr;
+            vector<Structure *> work = { st };
+            while ( !work.empty() ) {
+                auto cls = work.back();
+                work.pop_back();
+                if ( scan.uninitialized.count(cls) ) return nullptr;
+                auto it = scan.targets.find(cls);
+                if ( it!=scan.targets.end() ) {
+                    auto itf = it->second.find(name);
+                    if ( itf!=it->second.end() ) {
+                        for ( auto fn : itf->second ) {
+                            if ( !fn || (res && res!=fn) ) return nullptr;
+                            res = fn;
+                        }
+                    }
+                }
+                auto itd = derived.find(cls);
+                if ( itd!=derived.end() ) work.insert(work.end(), itd->second.begin(), itd->second.end());
+            }
+            return res;
+        }
+        // a, a.b, *a, etc. - dropping it does not lose any side effects
+        static bool isPath ( Expression * expr ) {
+            if ( expr->rtti_isVar() ) {
+                return true;
+            } else if ( expr->rtti_isR2V() ) {
+                return isPath(static_cast<ExprRef2Value *>(expr)->subexpr.get());
+            } else if ( expr->rtti_isPtr2Ref() && !expr->rtti_isNullCoalescing() ) {
+                return isPath(static_cast<ExprPtr2Ref *>(expr)->subexpr.get());
+            } else if ( expr->rtti_isField() ) {
+                auto field = static_cast<ExprField *>(expr);
+                return !field->annotation && isPath(field->value.get());
+            }
+            return false;
+        }
+        static bool isDerivedFrom ( Structure * st, Structure * base ) {
+            for ( auto s = st; s; s = s->parent ) {
+                if ( s==base ) return true;
+            }
+            return false;
+        }
+        // self argument, as the type of the method expects it
+        static ExpressionPtr selfArgument ( const ExpressionPtr & arg, Function * fn ) {
+            auto want = structOf(fn->arguments[0]->type);
+            if ( !want || !arg->type || arg->type->baseType!=Type::tStructure ) return nullptr;
+            if ( arg->type->structType==want ) return arg;
+            if ( arg->rtti_isCast() ) {     // cast<auto> *a from a->method(), which was cast to the class of the method field
+                auto sub = static_pointer_cast<ExprCast>(arg)->subexpr;
+                if ( sub->type && sub->type->baseType==Type::tStructure && sub->type->structType==want ) return sub;
+            }
+            if ( !isDerivedFrom(want, arg->type->structType) ) return nullptr;
+            auto castType = make_smart<TypeDecl>(*fn->arguments[0]->type);
+            castType->ref = false;
+            castType->constant = false;
+            auto cast = make_smart<ExprCast>(arg->at, arg, castType);
+            cast->upcast = true;
+            cast->type = make_smart<TypeDecl>(*castType);
+            cast->type->ref = arg->type->ref;
+            cast->type->constant = arg->type->constant;
+            return cast;
+        }
+        ExpressionPtr devirtualize ( ExprInvoke * expr ) {
+            if ( expr->arguments.size()<2 ) return nullptr;
+            auto method = expr->arguments[0].get();
+            if ( method->rtti_isR2V() ) method = static_cast<ExprRef2Value *>(method)->subexpr.get();
+            if ( !method->rtti_isField() ) return nullptr;
+            auto field = static_cast<ExprField *>(method);
+            if ( !field->field || !isMethodField(*field->field) || scan.written.count(field->name) ) return nullptr;
+            auto st = structOf(field->value->type);
+            if ( !st || !st->isClass || !isPath(field->value.get()) ) return nullptr;
+            auto fn = singleTarget(st, field->name);
+            if ( !fn || fn->builtIn || (fn->privateFunction && fn->module!=thisModule) ) return nullptr;
+            // the call must be the same as the invoke of the function pointer, except for the type of self
+            const auto & fnType = expr->arguments[0]->type;
+            if ( fn->arguments.size()!=fnType->argTypes.size() || fn->arguments.size()!=expr->arguments.size()-1 ) return nullptr;
+            if ( !fn->result->isSameType(*fnType->firstType,RefMatters::yes,ConstMatters::yes,TemporaryMatters::no) ) return nullptr;
+            for ( size_t i=1, is=fn->arguments.size(); i!=is; ++i ) {
+                if ( !fn->arguments[i]->type->isSameType(*fnType->argTypes[i],RefMatters::yes,ConstMatters::yes,TemporaryMatters::no) ) {
+                    return nullptr;
+                }
+            }
+            auto self = selfArgument(expr->arguments[1], fn);
+            if ( !self ) return nullptr;
+            auto call = make_smart<ExprCall>(expr->at, fn->name);
+            call->func = fn;
+            call->type = make_smart<TypeDecl>(*expr->type);
+            call->cmresAlias = expr->cmresAlias;
+            call->arguments.push_back(self);
+            for ( size_t i=2, is=expr->arguments.size(); i!=is; ++i ) {
+                call->arguments.push_back(expr->arguments[i]);
+            }
+            return call;
+        }
+        virtual ExpressionPtr visit ( ExprInvoke * expr ) override {
+            if ( auto res = devirtualize(expr) ) {
+                if ( log ) {
+                    auto fn = static_cast<ExprCallFunc *>(res.get())->func;
+                    logs << expr->at.describe() << ": " << *expr->arguments[0] << " devirtualized to " << fn->getMangledName() << "\n";
+                }
+                total ++;
+                reportFolding();
+                return res;
+            }
+            return Visitor::visit(expr);
+        }
+    };
+
+    bool Program::optimizationDevirtualization ( TextWriter & logs ) {
+        if ( !options.getBoolOption("devirtualize_methods", true) ) return false;
+        // otherwise somebody else can derive from our classes, or call functions, which we think are unused
+        if ( thisModule->isModule || policies.export_all || !options.getBoolOption("remove_unused_symbols",true) ) return false;
+        bool log = options.getBoolOption("log_devirtualize", false);
+        markExecutableSymbolUse();
+        DevirtualizeScan scan;
+        visitModulesInOrder(scan);
+        DevirtualizeCalls context(logs, scan, thisModule.get(), log);
+        context.collectHierarchy(library);
+        visit(context);
+        if ( log && context.total ) {
+            logs << "devirtualization: " << context.total << " method calls devirtualized\n";
+        }
+        return context.didAnything();
+    }
+}
@@ -0,0 +1,205 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/ast/ast.h"
+#include "daScript/ast/ast_visitor.h"
+
+namespace das {
+
+    // Escape analysis of local allocations.
+    // Pointer, which is initialized with 'new' of a small POD structure, and which is only ever
+    //      dereferenced (p.field, p?.field), compared (p==q, p!=q), or assigned to,
+    // never leaves the function. Such structure is allocated in the function's stack frame instead of the heap.
+    // Its contents have no pointers, so there is nothing for the GC to see there.
+    // Local array of POD elements, which is only ever
+    //      indexed, iterated over, grown, shrunk, or measured by builtin functions, or moved and cloned from and to,
+    // is not seen outside of its scope. Such array is deleted when the scope ends, as if it was declared 'var inscope'.
+    // Everything else (passing to functions, returning, capturing, taking address, delete, use under 'try') is an escape.
+    // Deleting the array is an AST change, so AOT code does it too. The 'onStack' flag only affects the interpreter,
+    // AOT ignores it and still allocates such 'new' on the heap.
+    // Program keeps the totals of both, see totalStackAllocations and totalScopedArrays.
+
+    static bool isScratchArrayBuiltin ( ExprCall * call ) {
+        if ( !call->func ) return false;
+        auto origin = call->func->getOriginPtr();
+        if ( !origin ) origin = call->func;
+        if ( !origin->module || origin->module->name!="$" ) return false;
+        const auto & name = origin->name;
+        return name=="length" || name=="capacity" || name=="empty"
+            || name=="resize" || name=="reserve" || name=="push" || name=="emplace" || name=="push_clone"
+            || name=="erase" || name=="pop" || name=="clear"
+            || name=="_resize_no_lockcheck" || name=="_reserve_no_lockcheck" || name=="_push_no_lockcheck"
+            || name=="_emplace_no_lockcheck" || name=="_push_clone_no_lockcheck";
+    }
+
+    class EscapeAnalysis : public Visitor {
+    public:
+        EscapeAnalysis ( bool arr, int32_t ms ) : arrays(arr), maxSize(ms) {}
+        struct Candidate {
+            Variable *  var;
+            ExprBlock * scope;
+        };
+        vector<Candidate>           candidates;
+        das_hash_set<Variable *>    escaped;
+    protected:
+        bool                        arrays;
+        int32_t                     maxSize;
+        das_hash_set<Variable *>    tracked;
+        vector<Expression *>        stack;
+        vector<ExprBlock *>         scopes;
+    protected:
+        virtual bool canVisitFunction ( Function * fun ) override {
+            return !fun->builtIn && !fun->generator;
+        }
+        virtual void preVisit ( Function * fun ) override {
+            Visitor::preVisit(fun);
+            stack.clear();
+            scopes.clear();
+        }
+        virtual void preVisit ( ExprBlock * block ) override {
+            Visitor::preVisit(block);
+            scopes.push_back(block);
+        }
+        virtual ExpressionPtr visit ( ExprBlock * block ) override {
+            scopes.pop_back();
+            return Visitor::visit(block);
+        }
+        virtual void preVisitExpression ( Expression * expr ) override {
+            Visitor::preVisitExpression(expr);
+            if ( expr->rtti_isVar() ) onVar(static_cast<ExprVar *>(expr));
+            stack.push_back(expr);
+        }
+        virtual ExpressionPtr visitExpression ( Expression * expr ) override {
+            if ( !stack.empty() && stack.back()==expr ) stack.pop_back();
+            return Visitor::visitExpression(expr);
+        }
+        virtual void preVisitLet ( ExprLet * expr, const VariablePtr & var, bool last ) override {
+            Visitor::preVisitLet(expr, var, last);
+            if ( scopes.empty() || var->type->ref ) return;
+            if ( arrays ? isScratchArray(var.get()) : isStackAllocation(var.get()) ) {
+                candidates.push_back({var.get(), scopes.back()});
+                tracked.insert(var.get());
+            }
+        }
+        bool isScratchArray ( Variable * var ) const {
+            const auto & vt = var->type;
+            if ( !vt->isGoodArrayType() || vt->isConst() || var->inScope ) return false;
+            if ( scopes.back()->inTheLoop ) return false;   // loop body runs its finally section once, after the loop
+            return vt->firstType->isRawPod();
+        }
+        bool isStackAllocation ( Variable * var ) const {
+            if ( !var->init || !var->type->isPointer() ) return false;
+            TypeDeclPtr st;
+            if ( var->init->rtti_isNew() ) {
+                auto enew = static_cast<ExprNew *>(var->init.get());
+                if ( !enew->type->dim.empty() ) return false;
+                st = enew->typeexpr;
+            } else if ( var->init->rtti_isAscend() ) {
+                auto asc = static_cast<ExprAscend *>(var->init.get());
+                if ( asc->needTypeInfo || !asc->subexpr->rtti_isMakeLocal() ) return false;
+                st = asc->subexpr->type;
+            } else {
+                return false;
+            }
+            if ( !st || st->baseType!=Type::tStructure || !st->dim.empty() || !st->structType ) return false;
+            if ( st->structType->persistent || !st->isRawPod() ) return false;
+            return st->getSizeOf() <= maxSize;
+        }
+        void onVar ( ExprVar * var ) {
+            if ( !var->local || !var->variable ) return;
+            auto pvar = var->variable.get();
+            if ( !tracked.count(pvar) || escaped.count(pvar) ) return;
+            if ( !(arrays ? isSafeArrayUse(var) : isSafePointerUse(var)) ) escaped.insert(pvar);
+        }
+        bool isSafePointerUse ( ExprVar * var ) const {
+            Expression * child = var;
+            for ( auto i = int32_t(stack.size())-1; i>=0; --i ) {
+                auto parent = stack[i];
+                if ( parent->rtti_isR2V() ) {
+                    child = parent;
+                    continue;
+                } else if ( parent->rtti_isField() || parent->rtti_isSafeField() ) {
+                    return static_cast<ExprField *>(parent)->value.get()==child;
+                } else if ( parent->rtti_isCopy() ) {
+                    return static_cast<ExprCopy *>(parent)->left.get()==child;
+                } else if ( parent->rtti_isOp2() ) {
+                    auto op = static_cast<ExprOp2 *>(parent);
+                    return op->op=="==" || op->op=="!=";
+                }
+                return false;
+            }
+            return false;
+        }
+        bool isSafeArrayUse ( ExprVar * var ) const {
+            if ( stack.empty() ) return false;
+            for ( auto expr : stack ) {     // exception may leave the array locked by the iteration
+                if ( expr->rtti_isTryCatch() ) return false;
+            }
+            auto parent = stack.back();
+            if ( parent->rtti_isAt() ) {
+                return static_cast<ExprAt *>(parent)->subexpr.get()==var;
+            } else if ( parent->rtti_isFor() ) {
+                return true;
+            } else if ( parent->rtti_isCall() ) {
+                auto call = static_cast<ExprCall *>(parent);
+                return !call->arguments.empty() && call->arguments[0].get()==var && isScratchArrayBuiltin(call);
+            } else if ( parent->rtti_isMove() || parent->rtti_isClone() ) {
+                return true;
+            }
+            return false;
+        }
+    };
+
+    bool Program::markNonEscapingArrays ( TextWriter & logs ) {
+        if ( !options.getBoolOption("escape_analysis", true) ) return false;
+        bool log = options.getBoolOption("log_escape_analysis", false);
+        EscapeAnalysis context(true, 0);
+        visit(context);
+        int32_t total = 0;
+        for ( auto & cand : context.candidates ) {
+            auto var = cand.var;
+            if ( context.escaped.count(var) ) continue;
+            if ( log ) {
+                logs << var->at.describe() << ": " << var->name << " is deleted at the end of its scope\n";
+            }
+            var->inScope = true;
+            auto eVar = make_smart<ExprVar>(var->at, var->name);
+            auto exprDel = make_smart<ExprDelete>(var->at, eVar);
+            cand.scope->finalList.insert(cand.scope->finalList.begin(), exprDel);
+            total ++;
+        }
+        totalScopedArrays += total;
+        if ( log && total ) {
+            logs << "escape analysis: " << total << " arrays deleted at the end of scope\n";
+        }
+        return total!=0;
+    }
+
+    void Program::markNonEscapingAllocations ( TextWriter & logs ) {
+        if ( !options.getBoolOption("escape_analysis", true) ) return;
+        bool log = options.getBoolOption("log_escape_analysis", false);
+        EscapeAnalysis context(false, options.getIntOption("escape_analysis_max_size", 256));
+        visit(context);
+        int32_t total = 0;
+        for ( auto & cand : context.candidates ) {
+            auto var = cand.var;
+            if ( context.escaped.count(var) ) continue;
+            if ( var->init->rtti_isAscend() ) {
+                auto asc = static_pointer_cast<ExprAscend>(var->init);
+                if ( asc->onStack ) continue;   // already moved, when the stack was allocated before
+                asc->onStack = true;
+            } else {
+                auto enew = static_pointer_cast<ExprNew>(var->init);
+                if ( enew->onStack ) continue;
+                enew->onStack = true;
+            }
+            if ( log ) {
+                logs << var->at.describe() << ": " << var->name << " is allocated on the stack\n";
+            }
+            total ++;
+        }
+        totalStackAllocations += total;
+        if ( log && total ) {
+            logs << "escape analysis: " << total << " heap allocations moved to the stack\n";
+        }
+    }
+}
@@ -0,0 +1,372 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/ast/ast.h"
+#include "daScript/ast/ast_visitor.h"
+
+namespace das {
+
+    // Calls to small leaf functions are replaced with the body of the function.
+    // Function qualifies, if its body is a single 'return' of a workhorse value, which only reads its arguments,
+    // globals of the same module, and constants, and only calls builtin functions without side effects.
+    // Call qualifies, if every argument is pure, and every argument which is not a simple variable or constant access
+    // is used exactly once (so that it is evaluated exactly once), unconditionally, and in the order of the arguments
+    // (so that the first argument to fail is the same one as with the call).
+    // There is no frame for the inlined code, so inlining is off under the debugger and the profiler.
+
+    static bool isPureBuiltin ( Function * fn ) {
+        if ( !fn || !fn->builtIn ) return false;
+        return (fn->sideEffectFlags & ~uint32_t(SideEffects::unsafe))==0;
+    }
+
+    static bool isPureIndex ( ExprAt * expr ) {
+        auto st = expr->subexpr->type;
+        if ( !st ) return false;
+        return !st->dim.empty() || st->isGoodArrayType() || st->isVectorType();
+    }
+
+    // copy of the expression, which keeps the flags of the folded nodes (clone() leaves them for the infer pass)
+    static ExpressionPtr cloneFolded ( const ExpressionPtr & expr ) {
+        auto cexpr = expr->clone();
+        if ( expr->rtti_isVar() ) {
+            static_pointer_cast<ExprVar>(cexpr)->varFlags = static_pointer_cast<ExprVar>(expr)->varFlags;
+        } else if ( expr->rtti_isR2V() ) {
+            static_pointer_cast<ExprRef2Value>(cexpr)->subexpr = cloneFolded(static_pointer_cast<ExprRef2Value>(expr)->subexpr);
+        } else if ( expr->rtti_isField() ) {
+            auto src = static_pointer_cast<ExprField>(expr);
+            auto dst = static_pointer_cast<ExprField>(cexpr);
+            dst->value = cloneFolded(src->value);
+            dst->annotation = src->annotation;
+            dst->derefFlags = src->derefFlags;
+            dst->fieldFlags = src->fieldFlags;
+        } else if ( expr->rtti_isSwizzle() ) {
+            auto src = static_pointer_cast<ExprSwizzle>(expr);
+            auto dst = static_pointer_cast<ExprSwizzle>(cexpr);
+            dst->value = cloneFolded(src->value);
+            dst->fields = src->fields;
+            dst->fieldFlags = src->fieldFlags;
+        } else if ( expr->rtti_isAt() ) {
+            auto src = static_pointer_cast<ExprAt>(expr);
+            auto dst = static_pointer_cast<ExprAt>(cexpr);
+            dst->subexpr = cloneFolded(src->subexpr);
+            dst->index = cloneFolded(src->index);
+            dst->atFlags = src->atFlags;
+        } else if ( expr->rtti_isCast() ) {
+            auto src = static_pointer_cast<ExprCast>(expr);
+            static_pointer_cast<ExprCast>(cexpr)->subexpr = cloneFolded(src->subexpr);
+        } else if ( expr->rtti_isOp1() ) {
+            static_pointer_cast<ExprOp1>(cexpr)->subexpr = cloneFolded(static_pointer_cast<ExprOp1>(expr)->subexpr);
+        } else if ( expr->rtti_isOp2() ) {
+            auto src = static_pointer_cast<ExprOp2>(expr);
+            auto dst = static_pointer_cast<ExprOp2>(cexpr);
+            dst->left = cloneFolded(src->left);
+            dst->right = cloneFolded(src->right);
+        } else if ( expr->rtti_isOp3() ) {
+            auto src = static_pointer_cast<ExprOp3>(expr);
+            auto dst = static_pointer_cast<ExprOp3>(cexpr);
+            dst->subexpr = cloneFolded(src->subexpr);
+            dst->left = cloneFolded(src->left);
+            dst->right = cloneFolded(src->right);
+        } else if ( expr->rtti_isCall() ) {
+            auto src = static_pointer_cast<ExprCall>(expr);
+            auto dst = static_pointer_cast<ExprCall>(cexpr);
+            for ( size_t i=0, is=src->arguments.size(); i!=is; ++i ) {
+                dst->arguments[i] = cloneFolded(src->arguments[i]);
+            }
+        }
+        return cexpr;
+    }
+
+    class InlineCalls : public PassVisitor {
+    public:
+        InlineCalls ( TextWriter & l, Module * m, int32_t ms, bool lg ) : logs(l), owner(m), maxSize(ms), log(lg) {}
+        int32_t total = 0;
+    protected:
+        struct InlineArg {
+            ExpressionPtr   expr;
+            int32_t         uses = 0;
+            int32_t         order = -1;         // when the first use is evaluated, relative to the other arguments
+            bool            conditional = false;
+            bool            simple = false;
+        };
+        TextWriter &                    logs;
+        Module *                        owner;
+        int32_t                         maxSize;
+        bool                            log;
+        das_hash_map<Function *,bool>   inlinable;
+        Function *                      callee = nullptr;
+        vector<InlineArg>               args;
+        int32_t                         useOrder = 0;
+        LineInfo                        callAt;
+        das_hash_map<FileInfo *,FileInfo *> inlinedFiles;   // file of the callee expression -> same file, as seen from this call
+        bool                            failed = false;
+    protected:
+        virtual bool canVisitFunction ( Function * fun ) override {
+            return !fun->builtIn;
+        }
+        // walks the whitelisted expression. callee!=null means arguments of callee and globals of its module are allowed,
+        // otherwise any variable is
+        bool isLeaf ( Expression * expr, Function * fn, int32_t & size ) const {
+            if ( ++size > maxSize && fn ) return false;
+            if ( expr->rtti_isConstant() ) {
+                return true;
+            } else if ( expr->rtti_isVar() ) {
+                auto var = static_cast<ExprVar *>(expr);
+                if ( !fn ) return true;
+                if ( var->argument ) return !var->block;
+                return !var->local && var->variable && var->variable->module==fn->module;
+            } else if ( expr->rtti_isR2V() ) {
+                return isLeaf(static_cast<ExprRef2Value *>(expr)->subexpr.get(), fn, size);
+            } else if ( expr->rtti_isField() ) {
+                return isLeaf(static_cast<ExprField *>(expr)->value.get(), fn, size);
+            } else if ( expr->rtti_isSwizzle() ) {
+                return isLeaf(static_cast<ExprSwizzle *>(expr)->value.get(), fn, size);
+            } else if ( expr->rtti_isAt() ) {
+                auto at = static_cast<ExprAt *>(expr);
+                return isPureIndex(at) && isLeaf(at->subexpr.get(), fn, size) && isLeaf(at->index.get(), fn, size);
+            } else if ( expr->rtti_isCast() ) {
+                return isLeaf(static_cast<ExprCast *>(expr)->subexpr.get(), fn, size);
+            } else if ( expr->rtti_isOp1() ) {
+                auto op = static_cast<ExprOp1 *>(expr);
+                return isPureBuiltin(op->func) && isLeaf(op->subexpr.get(), fn, size);
+            } else if ( expr->rtti_isOp2() ) {
+                auto op = static_cast<ExprOp2 *>(expr);
+                return isPureBuiltin(op->func) && isLeaf(op->left.get(), fn, size) && isLeaf(op->right.get(), fn, size);
+            } else if ( expr->rtti_isOp3() ) {
+                auto op = static_cast<ExprOp3 *>(expr);
+                return (!op->func || isPureBuiltin(op->func)) && isLeaf(op->subexpr.get(), fn, size)
+                    && isLeaf(op->left.get(), fn, size) && isLeaf(op->right.get(), fn, size);
+            } else if ( expr->rtti_isCall() ) {
+                auto call = static_cast<ExprCall *>(expr);
+                if ( !isPureBuiltin(call->func) ) return false;
+                for ( auto & arg : call->arguments ) {
+                    if ( !isLeaf(arg.get(), fn, size) ) return false;
+                }
+                return true;
+            }
+            return false;
+        }
+        // simple expression is cheap to evaluate more than once, and can't fail
+        static bool isSimple ( Expression * expr ) {
+            if ( expr->rtti_isConstant() || expr->rtti_isVar() ) {
+                return true;
+            } else if ( expr->rtti_isR2V() ) {
+                return isSimple(static_cast<ExprRef2Value *>(expr)->subexpr.get());
+            } else if ( expr->rtti_isField() ) {
+                auto field = static_cast<ExprField *>(expr);
+                return !field->annotation && field->value->type && !field->value->type->isPointer() && isSimple(field->value.get());
+            } else if ( expr->rtti_isSwizzle() ) {
+                return isSimple(static_cast<ExprSwizzle *>(expr)->value.get());
+            }
+            return false;
+        }
+        static ExpressionPtr returnValue ( Function * fn ) {
+            if ( !fn->body || !fn->body->rtti_isBlock() ) return nullptr;
+            auto block = static_pointer_cast<ExprBlock>(fn->body);
+            if ( block->list.size()!=1 || !block->finalList.empty() ) return nullptr;
+            if ( !block->list[0]->rtti_isReturn() ) return nullptr;
+            return static_pointer_cast<ExprReturn>(block->list[0])->subexpr;
+        }
+        bool canInline ( Function * fn ) {
+            auto it = inlinable.find(fn);
+            if ( it!=inlinable.end() ) return it->second;
+            bool res = false;
+            if ( !fn->builtIn && fn->annotations.empty() && fn->result && !fn->result->isRef() && fn->result->isWorkhorseType() ) {
+                auto value = returnValue(fn);
+                res = value != nullptr;
+                for ( auto & arg : fn->arguments ) {
+                    if ( !arg->type->isConst() ) res = false;      // 'var' arguments are local copies
+                }
+                int32_t size = 0;
+                res = res && isLeaf(value.get(), fn, size);
+            }
+            inlinable[fn] = res;
+            return res;
+        }
+        // walks the callee expression in the order of evaluation
+        void countUses ( Expression * expr, bool conditional ) {
+            if ( expr->rtti_isVar() ) {
+                auto var = static_cast<ExprVar *>(expr);
+                if ( var->argument && !var->block && var->argumentIndex>=0 && var->argumentIndex<int32_t(args.size()) ) {
+                    auto & arg = args[var->argumentIndex];
+                    if ( arg.uses++==0 ) arg.order = useOrder++;
+                    arg.conditional |= conditional;
+                }
+            } else if ( expr->rtti_isR2V() ) {
+                countUses(static_cast<ExprRef2Value *>(expr)->subexpr.get(), conditional);
+            } else if ( expr->rtti_isField() ) {
+                countUses(static_cast<ExprField *>(expr)->value.get(), conditional);
+            } else if ( expr->rtti_isSwizzle() ) {
+                countUses(static_cast<ExprSwizzle *>(expr)->value.get(), conditional);
+            } else if ( expr->rtti_isAt() ) {
+                countUses(static_cast<ExprAt *>(expr)->subexpr.get(), conditional);
+                countUses(static_cast<ExprAt *>(expr)->index.get(), conditional);
+            } else if ( expr->rtti_isCast() ) {
+                countUses(static_cast<ExprCast *>(expr)->subexpr.get(), conditional);
+            } else if ( expr->rtti_isOp1() ) {
+                countUses(static_cast<ExprOp1 *>(expr)->subexpr.get(), conditional);
+            } else if ( expr->rtti_isOp2() ) {
+                auto op = static_cast<ExprOp2 *>(expr);
+                countUses(op->left.get(), conditional);
+                countUses(op->right.get(), conditional || op->op=="&&" || op->op=="||");
+            } else if ( expr->rtti_isOp3() ) {
+                countUses(static_cast<ExprOp3 *>(expr)->subexpr.get(), conditional);
+                countUses(static_cast<ExprOp3 *>(expr)->left.get(), true);
+                countUses(static_cast<ExprOp3 *>(expr)->right.get(), true);
+            } else if ( expr->rtti_isCall() ) {
+                for ( auto & arg : static_cast<ExprCall *>(expr)->arguments ) countUses(arg.get(), conditional);
+            }
+        }
+        ExpressionPtr takeArg ( int32_t index ) {
+            auto & arg = args[index];
+            return arg.simple ? cloneFolded(arg.expr) : arg.expr;
+        }
+        // value of the argument
+        ExpressionPtr argValue ( int32_t index ) {
+            auto expr = takeArg(index);
+            if ( expr->rtti_isR2V() || !expr->type->isRef() ) return expr;
+            return Expression::autoDereference(expr);
+        }
+        // reference to the argument
+        ExpressionPtr argRef ( int32_t index ) {
+            auto & arg = args[index];
+            if ( arg.expr->rtti_isR2V() ) {
+                auto sub = static_pointer_cast<ExprRef2Value>(arg.expr)->subexpr;
+                return arg.simple ? cloneFolded(sub) : sub;
+            } else if ( arg.expr->type->isRef() || arg.expr->type->isRefType() ) {
+                return takeArg(index);
+            }
+            failed = true;      // argument is a temporary value, there is nothing to reference
+            return nullptr;
+        }
+        // expressions of the callee point to the inlined file info, which chains them to the call site
+        FileInfo * inlinedFile ( FileInfo * fi ) {
+            if ( !fi ) return nullptr;
+            auto it = inlinedFiles.find(fi);
+            if ( it!=inlinedFiles.end() ) return it->second;
+            InlinedFileInfo * res;
+            if ( auto at = fi->getInlinedAt() ) {
+                // callee had calls inlined into it, their chain continues through this call
+                auto inl = static_cast<InlinedFileInfo *>(fi);
+                LineInfo site = *at;
+                site.fileInfo = inlinedFile(at->fileInfo);
+                res = new InlinedFileInfo(inl->source, inl->function, site);
+            } else {
+                res = new InlinedFileInfo(fi, callee->name, callAt);
+            }
+            owner->inlinedFileInfo.emplace_back(res);
+            inlinedFiles[fi] = res;
+            return res;
+        }
+        static bool isArgument ( Expression * expr ) {
+            return expr->rtti_isVar() && static_cast<ExprVar *>(expr)->argument && !static_cast<ExprVar *>(expr)->block;
+        }
+        ExpressionPtr substitute ( const ExpressionPtr & expr ) {
+            if ( failed ) return nullptr;
+            if ( isArgument(expr.get()) ) {
+                auto var = static_pointer_cast<ExprVar>(expr);
+                if ( var->argumentIndex<0 || var->argumentIndex>=int32_t(args.size()) ) {
+                    failed = true;
+                    return nullptr;
+                }
+                return var->r2v ? argValue(var->argumentIndex) : argRef(var->argumentIndex);
+            } else if ( expr->rtti_isR2V() ) {
+                auto r2v = static_pointer_cast<ExprRef2Value>(expr);
+                if ( isArgument(r2v->subexpr.get()) && static_pointer_cast<ExprVar>(r2v->subexpr)->argumentIndex>=0 ) {
+                    return argValue(static_pointer_cast<ExprVar>(r2v->subexpr)->argumentIndex);
+                }
+                auto cexpr = static_pointer_cast<ExprRef2Value>(r2v->clone());
+                cexpr->at.fileInfo = inlinedFile(r2v->at.fileInfo);
+                cexpr->subexpr = substitute(r2v->subexpr);
+                return failed ? nullptr : cexpr;
+            }
+            auto cexpr = cloneFolded(expr);
+            cexpr->at.fileInfo = inlinedFile(expr->at.fileInfo);
+            if ( expr->rtti_isField() ) {
+                static_pointer_cast<ExprField>(cexpr)->value = substitute(static_pointer_cast<ExprField>(expr)->value);
+            } else if ( expr->rtti_isSwizzle() ) {
+                static_pointer_cast<ExprSwizzle>(cexpr)->value = substitute(static_pointer_cast<ExprSwizzle>(expr)->value);
+            } else if ( expr->rtti_isAt() ) {
+                auto src = static_pointer_cast<ExprAt>(expr);
+                auto dst = static_pointer_cast<ExprAt>(cexpr);
+                dst->subexpr = substitute(src->subexpr);
+                dst->index = substitute(src->index);
+            } else if ( expr->rtti_isCast() ) {
+                static_pointer_cast<ExprCast>(cexpr)->subexpr = substitute(static_pointer_cast<ExprCast>(expr)->subexpr);
+            } else if ( expr->rtti_isOp1() ) {
+                static_pointer_cast<ExprOp1>(cexpr)->subexpr = substitute(static_pointer_cast<ExprOp1>(expr)->subexpr);
+            } else if ( expr->rtti_isOp2() ) {
+                auto src = static_pointer_cast<ExprOp2>(expr);
+                auto dst = static_pointer_cast<ExprOp2>(cexpr);
+                dst->left = substitute(src->left);
+                dst->right = substitute(src->right);
+            } else if ( expr->rtti_isOp3() ) {
+                auto src = static_pointer_cast<ExprOp3>(expr);
+                auto dst = static_pointer_cast<ExprOp3>(cexpr);
+                dst->subexpr = substitute(src->subexpr);
+                dst->left = substitute(src->left);
+                dst->right = substitute(src->right);
+            } else if ( expr->rtti_isCall() ) {
+                auto src = static_pointer_cast<ExprCall>(expr);
+                auto dst = static_pointer_cast<ExprCall>(cexpr);
+                for ( size_t i=0, is=src->arguments.size(); i!=is; ++i ) {
+                    dst->arguments[i] = substitute(src->arguments[i]);
+                }
+            }
+            return failed ? nullptr : cexpr;
+        }
+        ExpressionPtr inlineCall ( ExprCall * call ) {
+            callee = call->func;
+            callAt = call->at;
+            inlinedFiles.clear();
+            if ( call->arguments.size()!=callee->arguments.size() ) return nullptr;
+            args.clear();
+            args.resize(call->arguments.size());
+            for ( size_t i=0, is=args.size(); i!=is; ++i ) {
+                auto & arg = call->arguments[i];
+                int32_t size = 0;
+                if ( !arg->type || !isLeaf(arg.get(), nullptr, size) ) return nullptr;
+                args[i].expr = arg;
+                args[i].simple = isSimple(arg.get());
+            }
+            auto value = returnValue(callee);
+            useOrder = 0;
+            countUses(value.get(), false);
+            int32_t lastOrder = -1;
+            for ( auto & arg : args ) {
+                if ( arg.simple ) continue;
+                if ( arg.uses!=1 || arg.conditional || arg.order<lastOrder ) return nullptr;
+                lastOrder = arg.order;
+            }
+            failed = false;
+            auto res = substitute(value);
+            if ( !res ) return nullptr;
+            if ( res->type->isRef() ) res = Expression::autoDereference(res);
+            return res;
+        }
+        virtual ExpressionPtr visit ( ExprCall * call ) override {
+            if ( call->func && canInline(call->func) ) {
+                if ( auto res = inlineCall(call) ) {
+                    if ( log ) {
+                        logs << call->at.describe() << ": " << call->func->getMangledName() << " inlined\n";
+                    }
+                    total ++;
+                    reportFolding();
+                    return res;
+                }
+            }
+            return Visitor::visit(call);
+        }
+    };
+
+    bool Program::optimizationInlining ( TextWriter & logs ) {
+        if ( !options.getBoolOption("inline_functions", true) ) return false;
+        if ( getDebugger() || getProfiler() ) return false;
+        bool log = options.getBoolOption("log_inline", false);
+        InlineCalls context(logs, thisModule.get(), options.getIntOption("inline_max_size", 16), log);
+        visit(context);
+        if ( log && context.total ) {
+            logs << "inlining: " << context.total << " calls inlined\n";
+        }
+        return context.didAnything();
+    }
+}
@@ -778,6 +778,7 @@ namespace das {
         "persistent_heap",              Type::tBool,
         "heap_size_hint",               Type::tInt,
         "heap_size_limit",              Type::tInt,
+        "heap_nursery_size",            Type::tInt,
         "string_heap_size_hint",        Type::tInt,
         "string_heap_size_limit",       Type::tInt,
         "gc",                           Type::tBool,
@@ -808,6 +809,10 @@ namespace das {
         "log_gmn_hash",                 Type::tBool,
         "log_ad_hash",                  Type::tBool,
         "log_aliasing",                 Type::tBool,
+        "log_lock_check_elision",       Type::tBool,
+        "log_inline",                   Type::tBool,
+        "log_escape_analysis",          Type::tBool,
+        "log_devirtualize",             Type::tBool,
         "print_ref",                    Type::tBool,
         "print_var_access",             Type::tBool,
         "print_c_style",                Type::tBool,
@@ -818,6 +823,11 @@ namespace das {
         "optimize",                     Type::tBool,
         "fusion",                       Type::tBool,
         "remove_unused_symbols",        Type::tBool,
+        "inline_functions",             Type::tBool,
+        "inline_max_size",              Type::tInt,
+        "escape_analysis",              Type::tBool,
+        "escape_analysis_max_size",     Type::tInt,
+        "devirtualize_methods",         Type::tBool,
     // language
         "always_export_initializer",    Type::tBool,
         "infer_time_folding",           Type::tBool,
@@ -826,11 +836,13 @@ namespace das {
         "indenting",                    Type::tInt,
     // debugger
         "debugger",                     Type::tBool,
+        "debugger_patching",            Type::tBool,
     // profiler
         "profiler",                     Type::tBool,
     // runtime checks
         "skip_lock_checks",             Type::tBool,
         "skip_module_lock_checks",      Type::tBool,
+        "lock_check_elision",           Type::tBool,
     // pinvoke
         "threadlock_context",           Type::tBool
     };
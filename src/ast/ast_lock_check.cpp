@@ -0,0 +1,150 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/ast/ast.h"
+#include "daScript/ast/ast_visitor.h"
+
+namespace das {
+
+    // Growing an array of lock-checked elements walks all the elements, looking for locked nested containers.
+    // Nested container can only be locked by an iterator or a borrow, which is alive while the array grows.
+    // For a local array, which is only ever
+    //      grown, shrunk, or measured by builtin functions (itself, or its nested containers),
+    //      read by value (arr[i].field),
+    //      assigned to, moved or cloned to or out of (var b <- arr included), returned, or deleted,
+    // such iterator or borrow can't exist. Those calls are redirected to the versions without the lock check.
+    // Everything else (passing by reference, iterating, capturing, taking address, blocks) keeps the runtime check.
+
+    static const char * lockFreeBuiltin ( ExprCall * call ) {
+        if ( !call->func || call->arguments.empty() ) return nullptr;
+        auto origin = call->func->getOriginPtr();
+        if ( !origin || !origin->module || origin->module->name!="$" ) return nullptr;
+        auto arrT = call->arguments[0]->type;
+        if ( !arrT || !arrT->isGoodArrayType() || !arrT->firstType->dim.empty() ) return nullptr;
+        if ( !arrT->firstType->lockCheck() ) return nullptr;
+        auto nargs = call->arguments.size();
+        auto isValue = [&]() {
+            auto valT = call->arguments[1]->type;
+            return valT && arrT->firstType->isSameType(*valT, RefMatters::no, ConstMatters::no, TemporaryMatters::no);
+        };
+        auto isInt = [&]( size_t i ) {
+            return call->arguments[i]->type && call->arguments[i]->type->isSimpleType(Type::tInt);
+        };
+        const auto & name = origin->name;
+        if ( name=="resize" && nargs==2 && isInt(1) ) return "_resize_no_lockcheck";
+        if ( name=="reserve" && nargs==2 && isInt(1) ) return "_reserve_no_lockcheck";
+        // values which can't be copied, moved, or cloned are left to the concept_assert of the original
+        if ( name=="push" && ((nargs==2 && isValue()) || (nargs==3 && isValue() && isInt(2))) && arrT->firstType->canCopy() ) return "_push_no_lockcheck";
+        if ( name=="emplace" && ((nargs==2 && isValue()) || (nargs==3 && isValue() && isInt(2))) && arrT->firstType->canMove() ) return "_emplace_no_lockcheck";
+        if ( name=="push_clone" && nargs==2 && isValue() && arrT->firstType->canClone() ) return "_push_clone_no_lockcheck";
+        return nullptr;
+    }
+
+    static bool isLockSafeBuiltin ( ExprCall * call ) {
+        if ( !call->func ) return false;
+        auto origin = call->func->getOriginPtr();
+        if ( !origin ) origin = call->func;
+        if ( !origin->module || origin->module->name!="$" ) return false;
+        const auto & name = origin->name;
+        return name=="length" || name=="capacity" || name=="empty"
+            || name=="resize" || name=="reserve" || name=="push" || name=="emplace" || name=="push_clone"
+            || name=="erase" || name=="pop" || name=="clear"
+            || name=="_return_with_lockcheck" || name=="_move_with_lockcheck"
+            || name=="_resize_no_lockcheck" || name=="_reserve_no_lockcheck" || name=="_push_no_lockcheck"
+            || name=="_emplace_no_lockcheck" || name=="_push_clone_no_lockcheck";
+    }
+
+    class LockCheckElision : public Visitor {
+    public:
+        LockCheckElision() {}
+        vector<ExprCall *>              candidates;
+        das_hash_map<Variable *,bool>   unsafe;     // local variable -> has uses, which can borrow
+    protected:
+        vector<Expression *>            stack;
+        int32_t                         blockDepth = 0;
+    protected:
+        virtual bool canVisitFunction ( Function * fun ) override {
+            return !fun->builtIn;
+        }
+        virtual void preVisit ( Function * fun ) override {
+            Visitor::preVisit(fun);
+            stack.clear();
+            blockDepth = 0;
+        }
+        virtual void preVisitExpression ( Expression * expr ) override {
+            Visitor::preVisitExpression(expr);
+            if ( expr->rtti_isMakeBlock() ) blockDepth ++;
+            if ( expr->rtti_isVar() ) onVar(static_cast<ExprVar *>(expr));
+            stack.push_back(expr);
+        }
+        virtual ExpressionPtr visitExpression ( Expression * expr ) override {
+            if ( !stack.empty() && stack.back()==expr ) stack.pop_back();
+            if ( expr->rtti_isMakeBlock() ) blockDepth --;
+            return Visitor::visitExpression(expr);
+        }
+        void onVar ( ExprVar * var ) {
+            if ( !var->local || var->argument || var->block || !var->variable ) return;
+            auto & isUnsafe = unsafe[var->variable.get()];
+            if ( isUnsafe ) return;
+            isUnsafe = blockDepth!=0 || !isSafeUse(var);
+        }
+        bool isSafeUse ( ExprVar * var ) {
+            Expression * child = var;
+            for ( auto i = int32_t(stack.size())-1; i>=0; --i ) {
+                auto parent = stack[i];
+                if ( parent->rtti_isAt() && static_cast<ExprAt *>(parent)->subexpr.get()==child ) {
+                    if ( static_cast<ExprAt *>(parent)->r2v ) return true;
+                } else if ( parent->rtti_isField() && static_cast<ExprField *>(parent)->value.get()==child ) {
+                    if ( static_cast<ExprField *>(parent)->r2v ) return true;
+                } else if ( parent->rtti_isR2V() ) {
+                    return true;
+                } else if ( parent->rtti_isCopy() ) {
+                    return static_cast<ExprOp2 *>(parent)->left.get()==child;
+                } else if ( parent->rtti_isMove() || parent->rtti_isClone() ) {
+                    return true;
+                } else if ( parent->rtti_isLet() ) {
+                    for ( const auto & lv : static_cast<ExprLet *>(parent)->variables ) {
+                        if ( lv->init.get()==child ) return lv->init_via_move || lv->init_via_clone;
+                    }
+                    return false;
+                } else if ( parent->rtti_isDelete() || parent->rtti_isReturn() ) {
+                    return true;
+                } else if ( parent->rtti_isCall() ) {
+                    auto call = static_cast<ExprCall *>(parent);
+                    if ( call->arguments.empty() || call->arguments[0].get()!=child ) return false;
+                    if ( child==var && lockFreeBuiltin(call) ) {
+                        candidates.push_back(call);
+                        return true;
+                    }
+                    return isLockSafeBuiltin(call);
+                } else {
+                    return false;
+                }
+                child = parent;
+            }
+            return false;
+        }
+    };
+
+    bool Program::elideLockChecks ( TextWriter & logs ) {
+        if ( !options.getBoolOption("lock_check_elision", true) ) return false;
+        bool log = options.getBoolOption("log_lock_check_elision", false);
+        LockCheckElision context;
+        visit(context);
+        int32_t total = 0;
+        for ( auto call : context.candidates ) {
+            auto var = static_cast<ExprVar *>(call->arguments[0].get());
+            if ( context.unsafe[var->variable.get()] ) continue;
+            if ( log ) {
+                logs << call->at.describe() << ": " << call->name << "(" << var->name << ") without lock check\n";
+            }
+            call->name = lockFreeBuiltin(call);
+            call->func = nullptr;
+            call->type = nullptr;
+            total ++;
+        }
+        if ( log && total ) {
+            logs << "lock check elision: " << total << " lock checks elided\n";
+        }
+        return total!=0;
+    }
+}
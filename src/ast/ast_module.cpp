@@ -136,6 +136,8 @@ namespace das {
         auto m = daScriptEnvironment::bound->modules;
         while ( m ) {
             finfos.emplace_back(das::move(m->ownFileInfo));
+            for ( auto & fi : m->inlinedFileInfo ) finfos.emplace_back(das::move(fi));
+            m->inlinedFileInfo.clear();
             m = m->next;
         }
     }
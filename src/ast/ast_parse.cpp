@@ -439,6 +439,12 @@ namespace das {
                 if ( program->patchAnnotations() ) {
                     goto restartInfer;
                 }
+                if ( program->getOptimize() && program->elideLockChecks(logs) ) {
+                    goto restartInfer;
+                }
+                if ( program->getOptimize() && program->markNonEscapingArrays(logs) ) {
+                    goto restartInfer;
+                }
             }
             if ( !program->failed() ) {
                 program->normalizeOptionTypes();
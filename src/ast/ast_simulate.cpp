@@ -465,7 +465,12 @@ namespace das
             if ( context.thisProgram->getDebugger() ) {
                 auto sbody = body->simulate(context);
                 if ( !sbody->rtti_node_isBlock() ) {
-                    auto block = context.code->makeNode<SimNodeDebug_BlockNF>(sbody->debugInfo);
+                    SimNode_Block * block;
+                    if ( context.thisProgram->getDebuggerPatching() ) {     // only statements in the block can be patched
+                        block = context.code->makeNode<SimNode_BlockNFT<1>>(sbody->debugInfo);
+                    } else {
+                        block = context.code->makeNode<SimNodeDebug_BlockNF>(sbody->debugInfo);
+                    }
                     block->total = 1;
                     block->list = (SimNode **) context.code->allocate(sizeof(SimNode *)*1);
                     block->list[0] = sbody;
@@ -1492,6 +1497,9 @@ namespace das
     }
 
     SimNode * ExprAscend::simulate (Context & context) const {
+        if ( onStack ) {
+            return subexpr->simulate(context);      // [[ ]] is made in place, and evaluates to its address
+        }
         auto se = subexpr->simulate(context);
         auto bytes = subexpr->type->getSizeOf();
         TypeInfo * typeInfo = nullptr;
@@ -1541,7 +1549,16 @@ namespace das
                 persistent = typeexpr->structType->persistent;
             }
             int32_t bytes = type->firstType->getBaseSizeOf();
-            if ( initializer ) {
+            if ( onStack ) {
+                if ( initializer ) {
+                    auto pCall = static_cast<SimNode_CallBase *>(func->makeSimNode(context,arguments));
+                    ExprCall::simulateCall(func, this, context, pCall);
+                    pCall->cmresEval = context.code->makeNode<SimNode_GetLocal>(at, stackTop);
+                    return pCall;
+                } else {
+                    return context.code->makeNode<SimNode_NewOnStack>(at, bytes, stackTop);
+                }
+            } else if ( initializer ) {
                 auto pCall = (SimNode_CallBase *) context.code->makeNodeUnrollAny<SimNode_NewWithInitializer>(
                     int(arguments.size()),at,bytes,persistent);
                 pCall->cmresEval = nullptr;
@@ -1844,7 +1861,7 @@ namespace das
                 bool needResult = type!=nullptr && type->baseType!=Type::tVoid;
                 bool C0 = !needResult && simlist.size()==1 && finalList.size()==0;
 #if DAS_DEBUGGER
-                if ( context.thisProgram->getDebugger() ) {
+                if ( context.thisProgram->getDebugNodes() ) {
                     block = context.code->makeNode<SimNodeDebug_ClosureBlock>(at, needResult, C0, annotationData);
                 } else
 #endif
@@ -1854,7 +1871,7 @@ namespace das
             } else {
                 if ( maxLabelIndex!=-1 ) {
 #if DAS_DEBUGGER
-                    if ( context.thisProgram->getDebugger() ) {
+                    if ( context.thisProgram->getDebugNodes() ) {
                         block = context.code->makeNode<SimNodeDebug_BlockWithLabels>(at);
                     } else
 #endif
@@ -1865,7 +1882,7 @@ namespace das
                 } else {
                     if ( finalList.size()==0 ) {
 #if DAS_DEBUGGER
-                        if ( context.thisProgram->getDebugger() ) {
+                        if ( context.thisProgram->getDebugNodes() ) {
                             block = context.code->makeNode<SimNodeDebug_BlockNF>(at);
                         } else
 #endif
@@ -1875,7 +1892,7 @@ namespace das
                         }
                     } else {
 #if DAS_DEBUGGER
-                        if ( context.thisProgram->getDebugger() ) {
+                        if ( context.thisProgram->getDebugNodes() ) {
                             block = context.code->makeNode<SimNodeDebug_Block>(at);
                         } else
 #endif
@@ -2066,6 +2083,21 @@ namespace das
         }
     }
 
+    static StringBuilderFormat getStringBuilderFormat ( const TypeDeclPtr & type ) {
+        if ( type->ref || !type->dim.empty() ) return StringBuilderFormat::walk;
+        switch ( type->baseType ) {
+            case Type::tBool:   return StringBuilderFormat::boolean;
+            case Type::tInt:    return StringBuilderFormat::int32;
+            case Type::tUInt:   return StringBuilderFormat::hex32;
+            case Type::tInt64:  return StringBuilderFormat::int64;
+            case Type::tUInt64: return StringBuilderFormat::hex64;
+            case Type::tFloat:  return StringBuilderFormat::float32;
+            case Type::tDouble: return StringBuilderFormat::float64;
+            case Type::tString: return StringBuilderFormat::string;
+            default:            return StringBuilderFormat::walk;
+        }
+    }
+
     SimNode * ExprStringBuilder::simulate (Context & context) const {
         SimNode_StringBuilder * pSB = context.code->makeNode<SimNode_StringBuilder>(isTempString, at);
         if ( int nArg = (int) elements.size() ) {
@@ -2076,6 +2108,35 @@ namespace das
                 pSB->arguments[a] = elements[a]->simulate(context);
                 pSB->types[a] = context.thisHelper->makeTypeInfo(nullptr, elements[a]->type);
             }
+            // consecutive literals are glued together, workhorse types get direct formatters
+            pSB->segments = (StringBuilderSegment *) context.code->allocate(nArg * sizeof(StringBuilderSegment));
+            string literal;
+            int literalHead = -1;
+            for ( int a=0; a!=nArg; ++a ) {
+                auto & seg = pSB->segments[a];
+                seg.text = nullptr;
+                seg.length = 0;
+                if ( elements[a]->rtti_isStringConstant() ) {
+                    if ( literalHead==-1 ) {
+                        literalHead = a;
+                        literal.clear();
+                        seg.format = StringBuilderFormat::literal;
+                    } else {
+                        seg.format = StringBuilderFormat::skip;
+                    }
+                    literal += static_pointer_cast<ExprConstString>(elements[a])->text;
+                    if ( a==nArg-1 || !elements[a+1]->rtti_isStringConstant() ) {
+                        auto & head = pSB->segments[literalHead];
+                        head.length = uint32_t(literal.length());
+                        head.text = head.length ? context.constStringHeap->impl_allocateString(literal) : nullptr;
+                        literalHead = -1;
+                    }
+                } else {
+                    seg.format = getStringBuilderFormat(elements[a]->type);
+                    pSB->scratchSize += getStringBuilderScratchSize(seg.format);
+                    if ( seg.format==StringBuilderFormat::walk ) pSB->hasWalk = true;
+                }
+            }
         } else {
             pSB->arguments = nullptr;
             pSB->types = nullptr;
@@ -2358,7 +2419,7 @@ namespace das
 
     SimNode * ExprTryCatch::simulate (Context & context) const {
 #if DAS_DEBUGGER
-        if ( context.thisProgram->getDebugger() ) {
+        if ( context.thisProgram->getDebugNodes() ) {
             return context.code->makeNode<SimNodeDebug_TryCatch>(at,
                                                     try_block->simulate(context),
                                                     catch_block->simulate(context));
@@ -2480,7 +2541,7 @@ namespace das
         bool condIfZero = false;
         bool match0 = matchEquNequZero(cond, zeroCond, condIfZero);
 #if DAS_DEBUGGER
-        if ( context.thisProgram->getDebugger() ) {
+        if ( context.thisProgram->getDebugNodes() ) {
             if ( match0 && zeroCond->type->isWorkhorseType() ) {
                 if ( condIfZero ) {
                     if ( if_false ) {
@@ -2569,7 +2630,7 @@ namespace das
 
     SimNode * ExprWhile::simulate (Context & context) const {
 #if DAS_DEBUGGER
-        if ( context.thisProgram->getDebugger() ) {
+        if ( context.thisProgram->getDebugNodes() ) {
             auto node = context.code->makeNode<SimNodeDebug_While>(at, cond->simulate(context));
             simulateFinal(context, body, node);
             return node;
@@ -2618,7 +2679,7 @@ namespace das
         if ( (sourceTypes>1) || hybridRange || nativeIterators || stringChars || /* this is how much we can unroll */ total>MAX_FOR_UNROLL ) {
             SimNode_ForWithIteratorBase * result;
 #if DAS_DEBUGGER
-            if ( context.thisProgram->getDebugger() ) {
+            if ( context.thisProgram->getDebugNodes() ) {
                 if ( total>MAX_FOR_UNROLL ) {
                     result = (SimNode_ForWithIteratorBase *) context.code->makeNode<SimNodeDebug_ForWithIteratorBase>(at);
                 } else {
@@ -2686,7 +2747,7 @@ namespace das
             auto subB = static_pointer_cast<ExprBlock>(body);
             bool loop1 = (subB->list.size() == 1);
 #if DAS_DEBUGGER
-            if ( context.thisProgram->getDebugger() ) {
+            if ( context.thisProgram->getDebugNodes() ) {
                 if ( dynamicArrays ) {
                     if (loop1) {
                         result = (SimNode_ForBase *) context.code->makeNodeUnrollNZ_FOR<SimNodeDebug_ForGoodArray1>(total, at);
@@ -3017,6 +3078,9 @@ namespace das
             context.stringHeap = make_smart<LinearStringAllocator>();
         }
         context.heap->setInitialSize ( options.getIntOption("heap_size_hint", policies.heap_size_hint) );
+        if ( auto nurserySize = options.getIntOption("heap_nursery_size", policies.heap_nursery_size) ) {
+            context.heap = make_smart<NurseryHeapAllocator>(context.heap, nurserySize);
+        }
         context.heap->setLimit ( options.getUInt64Option("heap_size_limit", policies.max_heap_allocated) );
         context.stringHeap->setInitialSize ( options.getIntOption("string_heap_size_hint", policies.string_heap_size_hint) );
         context.stringHeap->setLimit ( options.getUInt64Option("string_heap_size_limit", policies.max_string_heap_allocated) );
@@ -3355,6 +3419,9 @@ namespace das
             registerAotCpp(logs,context);
         }
         context.debugger = getDebugger();
+#if DAS_DEBUGGER
+        context.code->patchSingleStep = getDebuggerPatching();
+#endif
         isSimulating = false;
         context.thisHelper = &helper;   // note - we may need helper for the 'complete'
         auto boundProgram = daScriptEnvironment::bound->g_Program;
@@ -3475,6 +3542,9 @@ namespace das
                     if ( logIt ) logs << fn.mangledName << " AOT=0x" << HEX << semHash << DEC << "\n";
                     auto fcb = (SimNode_CallBase *) fn.code;
                     fn.aotFunction = fcb->aotFunction;
+                } else if ( getGlobalAotColdSet().count(semHash) ) {
+                    // cold function, profile guided AOT left it interpreted
+                    if ( logIt ) logs << fn.mangledName << " INTERPRETED AOT=0x" << HEX << semHash << DEC << "\n";
                 } else {
                     if ( logIt ) logs << "NOT FOUND " << fn.mangledName << " AOT=0x" << HEX << semHash << DEC << "\n";
                     TextWriter tp;
@@ -186,6 +186,7 @@ namespace das
         // RUNTIME
         addRuntime(lib);
         addRuntimeSort(lib);
+        addCoroutines(lib);
         // TIME
         addTime(lib);
         // NOW, for the builtin module
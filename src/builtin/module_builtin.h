@@ -10,6 +10,7 @@ namespace das {
     protected:
         void addRuntime(ModuleLibrary & lib);
         void addRuntimeSort(ModuleLibrary & lib);
+        void addCoroutines(ModuleLibrary & lib);
         void addVectorTypes(ModuleLibrary & lib);
         void addVectorCtor(ModuleLibrary & lib);
         void addArrayTypes(ModuleLibrary & lib);
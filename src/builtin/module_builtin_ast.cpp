@@ -618,6 +618,15 @@ namespace das {
         mod->options[option] = type;
     }
 
+    char * ast_mark_hot_aot ( smart_ptr_raw<Program> program, const char * profileFile, double coverage, int32_t inlineSize, Context * context, LineInfoArg * at ) {
+        if ( !program ) context->throw_error_at(at, "expecting program");
+        AotProfile profile;
+        TextWriter logs;
+        if ( !loadAotProfile(profileFile ? profileFile : "", profile, logs) ) context->throw_error_at(at, "%s", logs.str().c_str());
+        program->markHotAot(profile, coverage, inlineSize, logs);
+        return context->allocateString(logs.str(), at);
+    }
+
     TypeDeclPtr getUnderlyingValueType ( smart_ptr_raw<TypeDecl> type, Context * context, LineInfoArg * at ) {
         if ( !type ) context->throw_error_at(at, "expecting type");
         if ( type->baseType!=Type::tHandle ) context->throw_error_at(at, "expecting handle type");
@@ -939,6 +948,10 @@ namespace das {
         addExtern<DAS_BIND_FUN(addModuleOption)>(*this, lib,  "add_module_option",
             SideEffects::modifyExternal, "addModuleOption")
                 ->args({"module","option","type","context","at"});
+        // profile guided aot
+        addExtern<DAS_BIND_FUN(ast_mark_hot_aot)>(*this, lib,  "mark_hot_aot",
+            SideEffects::modifyArgumentAndExternal, "ast_mark_hot_aot")
+                ->args({"program","profile","coverage","inline_size","context","at"});
         // hash
         addExtern<DAS_BIND_FUN(getFunctionAotHash)>(*this, lib,  "get_function_aot_hash",
             SideEffects::none, "getFunctionAotHash")
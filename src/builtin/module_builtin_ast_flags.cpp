@@ -196,7 +196,8 @@ namespace das {
             "macroFunction", "needStringCast", "aotHashDeppendsOnArguments", "lateInit", "requestJit",
             "unsafeOutsideOfFor", "skipLockCheck", "safeImplicit", "deprecated", "aliasCMRES", "neverAliasCMRES",
             "addressTaken", "propertyFunction", "pinvoke", "jitOnly", "isStaticClassMethod", "requestNoJit",
-            "jitContextAndLineInfo", "nodiscard", "captureString", "callCaptureString", "hasStringBuilder"
+            "jitContextAndLineInfo", "nodiscard", "captureString", "callCaptureString", "hasStringBuilder",
+            "aotCold"
         };
         return ft;
     }
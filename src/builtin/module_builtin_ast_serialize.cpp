@@ -698,6 +698,7 @@ namespace das {
                 switch ( tag ) {
                     case 0: info = new FileInfo; break;
                     case 1: info = new TextFileInfo; break;
+                    case 2: info = new InlinedFileInfo; break;
                     default: SERIALIZER_VERIFYF(false, "Unreachable");
                 }
                 info->serialize(*this);
@@ -1519,7 +1520,7 @@ namespace das {
 
     void ExprNew::serialize(AstSerializer & ser) {
         ExprCallFunc::serialize(ser);
-        ser << typeexpr << initializer;
+        ser << typeexpr << initializer << onStack;
     }
 
     void ExprCall::serialize(AstSerializer & ser) {
@@ -1622,6 +1623,18 @@ namespace das {
         // }
     }
 
+    void InlinedFileInfo::serialize ( AstSerializer & ser ) {
+        uint8_t tag = 2; // Signify the inlined file info
+        if ( ser.writing ) {
+            ser << tag;
+        }
+        ser << name << tabSize << function;
+        ser << source << inlinedAt;
+        if ( !ser.writing ) {
+            ser.deleteUponFinish.push_back(this);
+        }
+    }
+
     AstSerializer & AstSerializer::operator << ( CallMacro * & ptr ) {
         tag("CallMacro *");
         if ( writing ) {
@@ -1881,6 +1894,7 @@ namespace das {
         if ( ser.failed ) return;
         ser << functionsByName << genericsByName;
         ser << ownFileInfo;     //<< promotedAccess;
+        ser << inlinedFileInfo;
 
         functions.foreach ([&] ( smart_ptr<Function> f ) {
             if ( ser.writing ) {
@@ -2003,6 +2017,7 @@ namespace das {
               << value.fail_on_no_aot
               << value.fail_on_lack_of_aot_export
               << value.debugger
+              << value.debugger_patching
               << value.debug_module
               << value.profiler
               << value.profile_module
@@ -2098,7 +2113,7 @@ namespace das {
     }
 
     uint32_t AstSerializer::getVersion () {
-        static constexpr uint32_t currentVersion = 15;
+        static constexpr uint32_t currentVersion = 17;
         return currentVersion;
     }
 
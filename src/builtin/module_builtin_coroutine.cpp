@@ -0,0 +1,105 @@
+#include "daScript/misc/platform.h"
+
+#include "module_builtin.h"
+
+#include "daScript/ast/ast_interop.h"
+#include "daScript/ast/ast_handle.h"
+#include "daScript/simulate/aot_builtin.h"
+#include "daScript/simulate/runtime_coroutine.h"
+
+MAKE_TYPE_FACTORY(CoroutineScheduler, das::CoroutineScheduler)
+
+namespace das
+{
+    struct CoroutineSchedulerAnnotation : ManagedStructureAnnotation<CoroutineScheduler,false> {
+        CoroutineSchedulerAnnotation(ModuleLibrary & ml) : ManagedStructureAnnotation ("CoroutineScheduler", ml) {
+            addProperty<DAS_BIND_MANAGED_PROP(running)>("running");
+            addProperty<DAS_BIND_MANAGED_PROP(waiting)>("waiting");
+        }
+    };
+
+    CoroutineScheduler * builtin_co_scheduler_create ( Context *, LineInfoArg * ) {
+        return new CoroutineScheduler();
+    }
+
+    void builtin_co_scheduler_remove ( CoroutineScheduler * & sched, Context * context, LineInfoArg * at ) {
+        if ( !sched ) context->throw_error_at(at, "coroutine scheduler is null");
+        sched->clear(context);
+        delete sched;
+        sched = nullptr;
+    }
+
+    void builtin_with_co_scheduler ( const TBlock<void,CoroutineScheduler *> & blk, Context * context, LineInfoArg * at ) {
+        CoroutineScheduler sched;
+        bool ok = context->runWithCatch([&](){
+            das_invoke<void>::invoke<CoroutineScheduler *>(context, at, blk, &sched);
+        });
+        sched.clear(context);
+        if ( !ok ) context->rethrow();
+    }
+
+    void builtin_co_scheduler_add ( CoroutineScheduler * sched, const Sequence & it, Context * context, LineInfoArg * at ) {
+        if ( !sched ) context->throw_error_at(at, "coroutine scheduler is null");
+        sched->add(context, (Sequence &)it);
+    }
+
+    bool builtin_co_scheduler_tick ( CoroutineScheduler * sched, Context * context, LineInfoArg * at ) {
+        if ( !sched ) context->throw_error_at(at, "coroutine scheduler is null");
+        return sched->tick(context);
+    }
+
+    int32_t builtin_co_scheduler_signal ( CoroutineScheduler * sched, int32_t event, Context * context, LineInfoArg * at ) {
+        if ( !sched ) context->throw_error_at(at, "coroutine scheduler is null");
+        return sched->signal(event);
+    }
+
+    void builtin_co_scheduler_clear ( CoroutineScheduler * sched, Context * context, LineInfoArg * at ) {
+        if ( !sched ) context->throw_error_at(at, "coroutine scheduler is null");
+        sched->clear(context);
+    }
+
+    bool builtin_co_transfer ( const Sequence & it ) {
+        return CoroutineScheduler::transfer((Sequence &)it);
+    }
+
+    bool builtin_co_wait ( int32_t event ) {
+        return CoroutineScheduler::wait(event);
+    }
+
+    void builtin_co_resumed () {
+        CoroutineScheduler::resumed();
+    }
+
+    void Module_BuiltIn::addCoroutines(ModuleLibrary & lib) {
+        addAnnotation(make_smart<CoroutineSchedulerAnnotation>(lib));
+        addExtern<DAS_BIND_FUN(builtin_co_scheduler_create)>(*this, lib, "coroutine_scheduler_create",
+            SideEffects::modifyExternal, "builtin_co_scheduler_create")
+                ->args({"context","line"});
+        addExtern<DAS_BIND_FUN(builtin_co_scheduler_remove)>(*this, lib, "coroutine_scheduler_remove",
+            SideEffects::modifyArgumentAndExternal, "builtin_co_scheduler_remove")
+                ->args({"scheduler","context","line"})->unsafeOperation = true;
+        addExtern<DAS_BIND_FUN(builtin_with_co_scheduler)>(*this, lib, "with_coroutine_scheduler",
+            SideEffects::invoke, "builtin_with_co_scheduler")
+                ->args({"block","context","line"});
+        addExtern<DAS_BIND_FUN(builtin_co_scheduler_add)>(*this, lib, "_builtin_co_scheduler_add",
+            SideEffects::modifyArgumentAndExternal, "builtin_co_scheduler_add")
+                ->args({"scheduler","it","context","line"});
+        addExtern<DAS_BIND_FUN(builtin_co_scheduler_tick)>(*this, lib, "_builtin_co_scheduler_tick",
+            SideEffects::modifyArgumentAndExternal, "builtin_co_scheduler_tick")
+                ->args({"scheduler","context","line"});
+        addExtern<DAS_BIND_FUN(builtin_co_scheduler_signal)>(*this, lib, "_builtin_co_scheduler_signal",
+            SideEffects::modifyArgumentAndExternal, "builtin_co_scheduler_signal")
+                ->args({"scheduler","event","context","line"});
+        addExtern<DAS_BIND_FUN(builtin_co_scheduler_clear)>(*this, lib, "_builtin_co_scheduler_clear",
+            SideEffects::modifyArgumentAndExternal, "builtin_co_scheduler_clear")
+                ->args({"scheduler","context","line"});
+        addExtern<DAS_BIND_FUN(builtin_co_transfer)>(*this, lib, "_builtin_co_transfer",
+            SideEffects::modifyArgumentAndExternal, "builtin_co_transfer")
+                ->args({"it"});
+        addExtern<DAS_BIND_FUN(builtin_co_wait)>(*this, lib, "_builtin_co_wait",
+            SideEffects::modifyExternal, "builtin_co_wait")
+                ->args({"event"});
+        addExtern<DAS_BIND_FUN(builtin_co_resumed)>(*this, lib, "_builtin_co_resumed",
+            SideEffects::modifyExternal, "builtin_co_resumed");
+    }
+}
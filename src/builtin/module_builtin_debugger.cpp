@@ -8,6 +8,8 @@
 #include "module_builtin_rtti.h"
 #include "daScript/misc/performance_time.h"
 #include "daScript/misc/sysos.h"
+#include "daScript/simulate/heap_sampler.h"
+#include "daScript/simulate/simulate_fusion.h"
 
 #include <condition_variable>
 #include <atomic>
@@ -776,6 +778,19 @@ namespace debugapi {
         context.setSingleStep(step);
     }
 
+    bool debuggerIsSupported () {
+        return DAS_DEBUGGER!=0;
+    }
+
+    int32_t hotPatchContext ( Context & ctx, Context & fresh ) {
+        if ( ctx.contextMutex ) {
+            lock_guard<recursive_mutex> guard(*ctx.contextMutex);
+            return ctx.hotPatch(&fresh);
+        } else {
+            return ctx.hotPatch(&fresh);
+        }
+    }
+
     void debuggerStackWalk ( Context & context, const LineInfo & lineInfo ) {
         context.stackWalk(&lineInfo, true, true);
     }
@@ -1111,9 +1126,73 @@ namespace debugapi {
     }
 
     void instrument_context_allocations ( Context & ctx, bool isInstrumenting ) {
+        if ( ctx.heapSampler ) {
+            ctx.heapSampler->ownsInstrumentation = !isInstrumenting;
+            isInstrumenting = true;
+        }
         ctx.instrumentAllocations = isInstrumenting;
     }
 
+    void heap_sampler_enable ( Context & ctx, uint64_t sampleRate, int32_t maxDepth ) {
+        ctx.enableHeapSampler(sampleRate, maxDepth);
+    }
+
+    void heap_sampler_disable ( Context & ctx ) {
+        ctx.disableHeapSampler();
+    }
+
+    int32_t heap_sampler_snapshot ( Context & ctx, Context * context, LineInfoArg * at ) {
+        if ( !ctx.heapSampler ) context->throw_error_at(at, "heap sampler is not enabled");
+        return ctx.heapSampler->snapshot();
+    }
+
+    char * heap_sampler_report ( Context & ctx, int32_t topN, Context * context, LineInfoArg * at ) {
+        if ( !ctx.heapSampler ) context->throw_error_at(at, "heap sampler is not enabled");
+        TextWriter tw;
+        ctx.heapSampler->report(tw, topN);
+        return context->allocateString(tw.str(), at);
+    }
+
+    char * heap_sampler_diff ( Context & ctx, int32_t fromSnapshot, int32_t toSnapshot, int32_t topN, Context * context, LineInfoArg * at ) {
+        if ( !ctx.heapSampler ) context->throw_error_at(at, "heap sampler is not enabled");
+        TextWriter tw;
+        ctx.heapSampler->reportDiff(tw, fromSnapshot, toSnapshot, topN);
+        return context->allocateString(tw.str(), at);
+    }
+
+    void reset_fusion_profile ( ) {
+#if DAS_FUSION_PROFILE
+        resetFusionProfile();
+#endif
+    }
+
+    char * collect_fusion_profile ( Context & ctx, int32_t topN, Context * context, LineInfoArg * at ) {
+        TextWriter tw;
+#if DAS_FUSION
+        collectFusionProfile(ctx, tw, topN);
+#else
+        (void)ctx; (void)topN;
+#endif
+        return context->allocateString(tw.str(), at);
+    }
+
+    char * generate_fusion_patterns ( Context & ctx, int32_t topN, Context * context, LineInfoArg * at ) {
+        TextWriter tw;
+#if DAS_FUSION
+        generateFusionPatterns(ctx, tw, topN);
+#else
+        (void)ctx; (void)topN;
+#endif
+        return context->allocateString(tw.str(), at);
+    }
+
+    char * heap_sampler_pprof ( Context & ctx, int32_t snapshot, int32_t baseSnapshot, Context * context, LineInfoArg * at ) {
+        if ( !ctx.heapSampler ) context->throw_error_at(at, "heap sampler is not enabled");
+        TextWriter tw;
+        ctx.heapSampler->writePprof(tw, snapshot, baseSnapshot);
+        return context->allocateString(tw.str(), at);
+    }
+
     void instrument_context ( Context & ctx, bool isInstrumenting, const TBlock<bool,LineInfo> & blk, Context * context, LineInfoArg * line ) {
         ctx.instrumentContextNode(blk, isInstrumenting, context, line);
     }
@@ -1245,6 +1324,11 @@ namespace debugapi {
             addExtern<DAS_BIND_FUN(debuggerSetContextSingleStep)>(*this, lib,  "set_single_step",
                 SideEffects::modifyExternal, "debuggerSetContextSingleStep")
                     ->args({"context","enabled"});
+            addExtern<DAS_BIND_FUN(debuggerIsSupported)>(*this, lib,  "is_debugger_supported",
+                SideEffects::none, "debuggerIsSupported");
+            addExtern<DAS_BIND_FUN(hotPatchContext)>(*this, lib,  "hot_patch_context",
+                SideEffects::modifyExternal, "hotPatchContext")
+                    ->args({"context","fresh"});
             addExtern<DAS_BIND_FUN(debuggerStackWalk)>(*this, lib, "stackwalk",
                 SideEffects::modifyExternal, "debuggerStackWalk")
                     ->args({"context","line"});
@@ -1255,6 +1339,33 @@ namespace debugapi {
             addExtern<DAS_BIND_FUN(instrument_context_allocations)>(*this, lib,  "instrument_context_allocations",
                 SideEffects::modifyExternal, "instrument_context_allocations")
                     ->args({"context","isInstrumenting"});
+            // sampling heap profiler
+            addExtern<DAS_BIND_FUN(heap_sampler_enable)>(*this, lib,  "heap_sampler_enable",
+                SideEffects::modifyExternal, "heap_sampler_enable")
+                    ->args({"context","sample_rate","max_depth"});
+            addExtern<DAS_BIND_FUN(heap_sampler_disable)>(*this, lib,  "heap_sampler_disable",
+                SideEffects::modifyExternal, "heap_sampler_disable")
+                    ->args({"context"});
+            addExtern<DAS_BIND_FUN(heap_sampler_snapshot)>(*this, lib,  "heap_sampler_snapshot",
+                SideEffects::modifyExternal, "heap_sampler_snapshot")
+                    ->args({"context","ctx","at"});
+            addExtern<DAS_BIND_FUN(heap_sampler_report)>(*this, lib,  "heap_sampler_report",
+                SideEffects::modifyExternal, "heap_sampler_report")
+                    ->args({"context","top","ctx","at"});
+            addExtern<DAS_BIND_FUN(heap_sampler_diff)>(*this, lib,  "heap_sampler_diff",
+                SideEffects::modifyExternal, "heap_sampler_diff")
+                    ->args({"context","from_snapshot","to_snapshot","top","ctx","at"});
+            addExtern<DAS_BIND_FUN(heap_sampler_pprof)>(*this, lib,  "heap_sampler_pprof",
+                SideEffects::modifyExternal, "heap_sampler_pprof")
+                    ->args({"context","snapshot","base_snapshot","ctx","at"});
+            addExtern<DAS_BIND_FUN(reset_fusion_profile)>(*this, lib,  "reset_fusion_profile",
+                SideEffects::modifyExternal, "reset_fusion_profile");
+            addExtern<DAS_BIND_FUN(collect_fusion_profile)>(*this, lib,  "collect_fusion_profile",
+                SideEffects::modifyExternal, "collect_fusion_profile")
+                    ->args({"context","top","ctx","at"});
+            addExtern<DAS_BIND_FUN(generate_fusion_patterns)>(*this, lib,  "generate_fusion_patterns",
+                SideEffects::modifyExternal, "generate_fusion_patterns")
+                    ->args({"context","top","ctx","at"});
             addExtern<DAS_BIND_FUN(instrument_context)>(*this, lib,  "instrument_node",
                 SideEffects::modifyExternal, "instrument_context")
                     ->args({"context","isInstrumenting","block","context","line"});
@@ -5,6 +5,7 @@
 #include "daScript/simulate/aot_builtin_fio.h"
 
 #include "daScript/simulate/simulate_nodes.h"
+#include "daScript/simulate/bin_serializer.h"
 #include "daScript/ast/ast_interop.h"
 #include "daScript/ast/ast_policy_types.h"
 #include "daScript/ast/ast_handle.h"
@@ -222,7 +223,9 @@ namespace das {
         struct stat st;
         int fd = fileno((FILE *)f);
         fstat(fd, &st);
-        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        // private copy-on-write mapping, so that the data can be patched in place (i.e. flat_view fixups)
+        void* data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if ( data==MAP_FAILED ) context->throw_error_at(at, "can't map file");
         Array arr;
         arr.data = (char *) data;
         arr.capacity = arr.size = uint32_t(st.st_size);
@@ -607,6 +610,9 @@ namespace das {
             addExtern<DAS_BIND_FUN(builtin_map_file)>(*this, lib, "fmap",
                 SideEffects::modifyExternal, "builtin_map_file")
                     ->args({"file","block","context","line"});
+            addInterop<_builtin_flat_save_file,uint64_t,const vec4f,const FILE *>(*this, lib, "_builtin_flat_save_file",
+                SideEffects::modifyExternal, "_builtin_flat_save_file")
+                    ->args({"data","file"});
             addExtern<DAS_BIND_FUN(builtin_fgets)>(*this, lib, "fgets",
                 SideEffects::modifyExternal, "builtin_fgets")
                     ->args({"file","context","line"});
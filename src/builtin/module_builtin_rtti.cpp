@@ -34,6 +34,7 @@ IMPLEMENT_EXTERNAL_TYPE_FACTORY(Module,Module)
 IMPLEMENT_EXTERNAL_TYPE_FACTORY(Error,Error)
 IMPLEMENT_EXTERNAL_TYPE_FACTORY(FileAccess,FileAccess)
 IMPLEMENT_EXTERNAL_TYPE_FACTORY(Context,Context)
+IMPLEMENT_EXTERNAL_TYPE_FACTORY(ContextTenant,ContextTenant)
 IMPLEMENT_EXTERNAL_TYPE_FACTORY(SimFunction,SimFunction)
 IMPLEMENT_EXTERNAL_TYPE_FACTORY(CodeOfPolicies,CodeOfPolicies)
 IMPLEMENT_EXTERNAL_TYPE_FACTORY(recursive_mutex,das::recursive_mutex)
@@ -256,6 +257,11 @@ namespace das {
             // addProperty<DAS_BIND_MANAGED_PROP(getSource)>("source");
             // addField<DAS_BIND_MANAGED_FIELD(sourceLength)>("sourceLength");
             addField<DAS_BIND_MANAGED_FIELD(tabSize)>("tabSize");
+            addProperty<DAS_BIND_MANAGED_PROP(getInlinedFunction)>("inlinedFunction","getInlinedFunction");
+        }
+        void init() {
+            // LineInfo refers to FileInfo, so this one is added after both are registered
+            addProperty<DAS_BIND_MANAGED_PROP(getInlinedAt)>("inlinedAt","getInlinedAt");
         }
     };
 
@@ -305,6 +311,22 @@ namespace das {
         }
     };
 
+    struct ContextTenantAnnotation : ManagedStructureAnnotation<ContextTenant,false,true> {
+        ContextTenantAnnotation(ModuleLibrary & ml) : ManagedStructureAnnotation ("ContextTenant", ml) {
+            addField<DAS_BIND_MANAGED_FIELD(name)>("name");
+            addProperty<DAS_BIND_MANAGED_PROP(getLimit)>("limit","getLimit");
+            addProperty<DAS_BIND_MANAGED_PROP(getSoftLimit)>("softLimit","getSoftLimit");
+            addProperty<DAS_BIND_MANAGED_PROP(getTimeBudgetUsec)>("timeBudgetUsec","getTimeBudgetUsec");
+            addProperty<DAS_BIND_MANAGED_PROP(getBytes)>("bytes","getBytes");
+            addProperty<DAS_BIND_MANAGED_PROP(getPeakBytes)>("peakBytes","getPeakBytes");
+            addProperty<DAS_BIND_MANAGED_PROP(getAllocations)>("allocations","getAllocations");
+            addProperty<DAS_BIND_MANAGED_PROP(getFailedAllocations)>("failedAllocations","getFailedAllocations");
+            addProperty<DAS_BIND_MANAGED_PROP(getSoftLimitHits)>("softLimitHits","getSoftLimitHits");
+            addProperty<DAS_BIND_MANAGED_PROP(getCollections)>("collections","getCollections");
+            addProperty<DAS_BIND_MANAGED_PROP(getBudgetStops)>("budgetStops","getBudgetStops");
+        }
+    };
+
     TypeDeclPtr makeSimFunctionFlags() {
         auto ft = make_smart<TypeDecl>(Type::tBitfield);
         ft->alias = "SimFunctionFlags";
@@ -350,6 +372,8 @@ namespace das {
             addFieldEx ( "flags", "flags", offsetof(Program, flags), makeProgramFlags() );
             addField<DAS_BIND_MANAGED_FIELD(errors)>("errors");
             addField<DAS_BIND_MANAGED_FIELD(options)>("_options","options");
+            addField<DAS_BIND_MANAGED_FIELD(totalStackAllocations)>("totalStackAllocations");
+            addField<DAS_BIND_MANAGED_FIELD(totalScopedArrays)>("totalScopedArrays");
         }
     };
 
@@ -702,6 +726,7 @@ namespace das {
             addField<DAS_BIND_MANAGED_FIELD(multiple_contexts)>("multiple_contexts");
             addField<DAS_BIND_MANAGED_FIELD(heap_size_hint)>("heap_size_hint");
             addField<DAS_BIND_MANAGED_FIELD(string_heap_size_hint)>("string_heap_size_hint");
+            addField<DAS_BIND_MANAGED_FIELD(heap_nursery_size)>("heap_nursery_size");
             addField<DAS_BIND_MANAGED_FIELD(solid_context)>("solid_context");
             addField<DAS_BIND_MANAGED_FIELD(macro_context_persistent_heap)>("macro_context_persistent_heap");
             addField<DAS_BIND_MANAGED_FIELD(macro_context_collect)>("macro_context_collect");
@@ -741,6 +766,7 @@ namespace das {
             addField<DAS_BIND_MANAGED_FIELD(fail_on_lack_of_aot_export)>("fail_on_lack_of_aot_export");
         // debugger
             addField<DAS_BIND_MANAGED_FIELD(debugger)>("debugger");
+            addField<DAS_BIND_MANAGED_FIELD(debugger_patching)>("debugger_patching");
             addField<DAS_BIND_MANAGED_FIELD(debug_module)>("debug_module");
         // profiler
             addField<DAS_BIND_MANAGED_FIELD(profiler)>("profiler");
@@ -819,6 +845,69 @@ namespace das {
         }
     }
 
+    void rtti_fork_context ( Context & source, const TBlock<void,smart_ptr<Context>> & block, Context * context, LineInfoArg * at ) {
+        smart_ptr<Context> fork;
+        string error;
+        {
+            unique_ptr<lock_guard<recursive_mutex>> guard;
+            if ( source.contextMutex ) guard = make_unique<lock_guard<recursive_mutex>>(*source.contextMutex);
+            fork = new Context(source, source.category.value, false);
+            if ( !fork->forkFrom(source, error) ) fork.reset();
+        }
+        if ( !fork ) context->throw_error_at(at, "fork_context failed, %s", error.c_str());
+        das_invoke<void>::invoke<smart_ptr<Context>>(context,at,block,fork);
+    }
+
+    smart_ptr<ContextTenant> rtti_make_tenant ( const char * name, uint64_t limit, uint64_t softLimit ) {
+        return make_smart<ContextTenant>(name ? name : "", limit, softLimit);
+    }
+
+    smart_ptr<ContextTenant> rtti_make_sub_tenant ( const char * name, uint64_t limit, uint64_t softLimit, smart_ptr_raw<ContextTenant> parent ) {
+        return make_smart<ContextTenant>(name ? name : "", limit, softLimit, parent);
+    }
+
+    void rtti_set_context_tenant ( Context & ctx, smart_ptr_raw<ContextTenant> tenant, Context * context, LineInfoArg * at ) {
+        if ( &ctx==context ) context->throw_error_at(at, "can't change tenant of the running context");
+        unique_ptr<lock_guard<recursive_mutex>> guard;
+        if ( ctx.contextMutex ) guard = make_unique<lock_guard<recursive_mutex>>(*ctx.contextMutex);
+        ctx.setTenant(tenant);
+    }
+
+    void rtti_clear_context_tenant ( Context & ctx, Context * context, LineInfoArg * at ) {
+        rtti_set_context_tenant(ctx, nullptr, context, at);
+    }
+
+    smart_ptr<ContextTenant> rtti_get_context_tenant ( Context & ctx ) {
+        return ctx.tenant;
+    }
+
+    // calling context would collect, or stop itself in the middle of the call
+    static void rtti_verify_foreign_tenant ( ContextTenant * tenant, const char * what, Context * context, LineInfoArg * at ) {
+        for ( auto t = context->tenant.get(); t; t = t->parent.get() ) {
+            if ( t==tenant ) context->throw_error_at(at, "can't %s tenant '%s' from the context it owns", what, tenant->name.c_str());
+        }
+    }
+
+    int32_t rtti_tenant_collect ( smart_ptr_raw<ContextTenant> tenant, Context * context, LineInfoArg * at ) {
+        rtti_verify_foreign_tenant(tenant.get(), "collect", context, at);
+        return tenant->collectIdle(nullptr);
+    }
+
+    void rtti_tenant_start_budget ( smart_ptr_raw<ContextTenant> tenant, uint64_t usec, Context * context, LineInfoArg * at ) {
+        rtti_verify_foreign_tenant(tenant.get(), "start budget of", context, at);
+        tenant->startBudget(usec);
+    }
+
+    bool rtti_tenant_check_budget ( smart_ptr_raw<ContextTenant> tenant, Context * context, LineInfoArg * at ) {
+        rtti_verify_foreign_tenant(tenant.get(), "check budget of", context, at);
+        return tenant->checkBudget();
+    }
+
+    void rtti_tenant_stop ( smart_ptr_raw<ContextTenant> tenant, Context * context, LineInfoArg * at ) {
+        rtti_verify_foreign_tenant(tenant.get(), "stop", context, at);
+        tenant->stop();
+    }
+
     void rtti_builtin_compile ( char * modName, char * str, const CodeOfPolicies & cop,
             const TBlock<void,bool,smart_ptr<Program>,const string> & block, Context * context, LineInfoArg * at ) {
         return rtti_builtin_compile_ex(modName, str, cop, true, block, context, at);
@@ -1362,12 +1451,15 @@ namespace das {
             // enums
             addEnumeration(make_smart<EnumerationCompilationError>());
             // type annotations
-            addAnnotation(make_smart<FileInfoAnnotation>(lib));
+            auto fia = make_smart<FileInfoAnnotation>(lib);
+            addAnnotation(fia);
             addAnnotation(make_smart<LineInfoAnnotation>(lib));
+            initRecAnnotation(fia, lib);
                 addCtor<LineInfo>(*this,lib,"LineInfo","LineInfo");
                 addCtor<LineInfo,FileInfo *,int,int,int,int>(*this,lib,"LineInfo","LineInfo");
             addAnnotation(make_smart<DummyTypeAnnotation>("recursive_mutex","recursive_mutex",sizeof(recursive_mutex),alignof(recursive_mutex)));
             addUsing<recursive_mutex>(*this, lib, "das::recursive_mutex");
+            addAnnotation(make_smart<ContextTenantAnnotation>(lib));
             addAnnotation(make_smart<ContextAnnotation>(lib));
             addAnnotation(make_smart<ErrorAnnotation>(lib));
             addAnnotation(make_smart<FileAccessAnnotation>(lib));
@@ -1456,6 +1548,36 @@ namespace das {
             addExtern<DAS_BIND_FUN(rtti_builtin_simulate)>(*this, lib, "simulate",
                 SideEffects::modifyExternal, "rtti_builtin_simulate")
                     ->args({"program","block","context","line"});
+            addExtern<DAS_BIND_FUN(rtti_fork_context)>(*this, lib, "fork_context",
+                SideEffects::modifyExternal, "rtti_fork_context")
+                    ->args({"source","block","context","line"});
+            addExtern<DAS_BIND_FUN(rtti_make_tenant)>(*this, lib, "make_tenant",
+                SideEffects::modifyExternal, "rtti_make_tenant")
+                    ->args({"name","limit","soft_limit"});
+            addExtern<DAS_BIND_FUN(rtti_make_sub_tenant)>(*this, lib, "make_tenant",
+                SideEffects::modifyExternal, "rtti_make_sub_tenant")
+                    ->args({"name","limit","soft_limit","parent"});
+            addExtern<DAS_BIND_FUN(rtti_set_context_tenant)>(*this, lib, "set_context_tenant",
+                SideEffects::modifyExternal, "rtti_set_context_tenant")
+                    ->args({"ctx","tenant","context","line"});
+            addExtern<DAS_BIND_FUN(rtti_clear_context_tenant)>(*this, lib, "clear_context_tenant",
+                SideEffects::modifyExternal, "rtti_clear_context_tenant")
+                    ->args({"ctx","context","line"});
+            addExtern<DAS_BIND_FUN(rtti_get_context_tenant)>(*this, lib, "get_context_tenant",
+                SideEffects::accessExternal, "rtti_get_context_tenant")
+                    ->arg("ctx");
+            addExtern<DAS_BIND_FUN(rtti_tenant_collect)>(*this, lib, "tenant_collect",
+                SideEffects::modifyExternal, "rtti_tenant_collect")
+                    ->args({"tenant","context","line"});
+            addExtern<DAS_BIND_FUN(rtti_tenant_start_budget)>(*this, lib, "tenant_start_budget",
+                SideEffects::modifyExternal, "rtti_tenant_start_budget")
+                    ->args({"tenant","usec","context","line"});
+            addExtern<DAS_BIND_FUN(rtti_tenant_check_budget)>(*this, lib, "tenant_check_budget",
+                SideEffects::modifyExternal, "rtti_tenant_check_budget")
+                    ->args({"tenant","context","line"});
+            addExtern<DAS_BIND_FUN(rtti_tenant_stop)>(*this, lib, "tenant_stop",
+                SideEffects::modifyExternal, "rtti_tenant_stop")
+                    ->args({"tenant","context","line"});
             addExtern<DAS_BIND_FUN(makeFileAccess)>(*this, lib, "make_file_access",
                 SideEffects::modifyExternal, "makeFileAccess")
                     ->args({"project","context","at"});
@@ -806,6 +806,30 @@ namespace das
         context->collectHeap(info, sheap, validate);
     }
 
+    void heap_collect_nursery ( Context * context, LineInfoArg * info ) {
+        context->collectNursery(info);
+    }
+
+    uint64_t heap_nursery_bytes_allocated ( Context * context ) {
+        auto nursery = context->heap->asNursery();
+        return nursery ? nursery->youngBytes() : 0;
+    }
+
+    uint64_t heap_nursery_bytes_promoted ( Context * context ) {
+        auto nursery = context->heap->asNursery();
+        return nursery ? nursery->bytesPromoted : 0;
+    }
+
+    uint64_t heap_nursery_regions_retired ( Context * context ) {
+        auto nursery = context->heap->asNursery();
+        return nursery ? nursery->regionsRetired : 0;
+    }
+
+    uint64_t heap_nursery_regions_freed ( Context * context ) {
+        auto nursery = context->heap->asNursery();
+        return nursery ? nursery->regionsFreed : 0;
+    }
+
     void heap_report ( Context * context, LineInfoArg * info ) {
         context->heap->report();
         context->reportAnyHeap(info, false, true, false, false);
@@ -1644,6 +1668,22 @@ namespace das
         hcol->unsafeOperation = true;
         hcol->arguments[0]->init = make_smart<ExprConstBool>(true);
         hcol->arguments[1]->init = make_smart<ExprConstBool>(false);
+        auto hncol = addExtern<DAS_BIND_FUN(heap_collect_nursery)>(*this, lib, "heap_collect_nursery",
+                SideEffects::modifyExternal, "heap_collect_nursery")
+                    ->args({"context","at"});
+        hncol->unsafeOperation = true;
+        addExtern<DAS_BIND_FUN(heap_nursery_bytes_allocated)>(*this, lib, "heap_nursery_bytes_allocated",
+            SideEffects::modifyExternal, "heap_nursery_bytes_allocated")
+                ->arg("context");
+        addExtern<DAS_BIND_FUN(heap_nursery_bytes_promoted)>(*this, lib, "heap_nursery_bytes_promoted",
+            SideEffects::modifyExternal, "heap_nursery_bytes_promoted")
+                ->arg("context");
+        addExtern<DAS_BIND_FUN(heap_nursery_regions_retired)>(*this, lib, "heap_nursery_regions_retired",
+            SideEffects::modifyExternal, "heap_nursery_regions_retired")
+                ->arg("context");
+        addExtern<DAS_BIND_FUN(heap_nursery_regions_freed)>(*this, lib, "heap_nursery_regions_freed",
+            SideEffects::modifyExternal, "heap_nursery_regions_freed")
+                ->arg("context");
         addExtern<DAS_BIND_FUN(string_heap_report)>(*this, lib, "string_heap_report",
             SideEffects::modifyExternal, "string_heap_report")
                 ->args({"context","line"});
@@ -1663,6 +1703,13 @@ namespace das
         addInterop<_builtin_binary_save,void,const vec4f,const Block &>(*this, lib, "_builtin_binary_save",
             SideEffects::modifyExternal, "_builtin_binary_save")
                 ->args({"data","block"});
+        // flat serializer
+        addInterop<_builtin_flat_save,void,const vec4f,const Block &>(*this, lib, "_builtin_flat_save",
+            SideEffects::modifyExternal, "_builtin_flat_save")
+                ->args({"data","block"});
+        addInterop<_builtin_flat_view,void,vec4f,const Array &,const Block &>(*this, lib, "_builtin_flat_view",
+            SideEffects::modifyArgumentAndExternal, "_builtin_flat_view")
+                ->args({"type","data","block"});
         // function-like expresions
         addCall<ExprAssert>         ("assert",false);
         addCall<ExprAssert>         ("verify",true);
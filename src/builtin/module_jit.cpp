@@ -88,33 +88,13 @@ extern "C" {
     }
 
     char * jit_string_builder ( Context & context, SimNode_CallBase * call, vec4f * args ) {
-        StringBuilderWriter writer;
-        DebugDataWalker<StringBuilderWriter> walker(writer, PrintFlags::string_builder);
-        for ( int i=0, is=call->nArguments; i!=is; ++i ) {
-            walker.walk(args[i], call->types[i]);
-        }
-        auto length = writer.tellp();
-        if ( length ) {
-            return context.allocateString(writer.c_str(), uint32_t(length),&call->debugInfo);
-        } else {
-            return nullptr;
-        }
+        return static_cast<SimNode_StringBuilder *>(call)->buildString(context, args);
     }
 
     char * jit_string_builder_temp ( Context & context, SimNode_CallBase * call, vec4f * args ) {
-        StringBuilderWriter writer;
-        DebugDataWalker<StringBuilderWriter> walker(writer, PrintFlags::string_builder);
-        for ( int i=0, is=call->nArguments; i!=is; ++i ) {
-            walker.walk(args[i], call->types[i]);
-        }
-        auto length = writer.tellp();
-        if ( length ) {
-            auto str = context.allocateString(writer.c_str(), uint32_t(length),&call->debugInfo);
-            context.freeTempString(str,&call->debugInfo);
-            return str;
-        } else {
-            return nullptr;
-        }
+        auto str = static_cast<SimNode_StringBuilder *>(call)->buildString(context, args);
+        if ( str ) context.freeTempString(str,&call->debugInfo);
+        return str;
     }
 
 
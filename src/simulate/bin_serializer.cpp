@@ -39,7 +39,7 @@ namespace das {
         }
         __forceinline void write ( void * data, uint32_t size ) {
             if ( bytesWritten + size > bytesAllocated ) {
-                uint32_t newSize = das::max ( bytesAllocated + bytesGrow, bytesWritten + size );
+                uint32_t newSize = das::max ( das::max(bytesAllocated * 2, bytesGrow), bytesWritten + size );
                 bytesAt = context->reallocate(bytesAt, bytesAllocated, newSize);
                 context->heap->mark_comment(bytesAt, "binary serializer write");
                 bytesAllocated = newSize;
@@ -274,6 +274,328 @@ namespace das {
         }
     };
 
+    // flat binary format
+    //  header | root object | array data and strings | fixup table | footer
+    //  every block is 16 bytes aligned, so that the image can be used in place (i.e. from the mapped file)
+    //  pointers in the image are offsets from its beginning, and the fixup table lists where they are
+
+    struct FlatHeader {
+        uint32_t    magic;
+        uint32_t    version;
+        uint64_t    hash;           // layout hash of the root object
+        uint64_t    base;           // address, which pointers are relative to. 0 for offsets
+        uint32_t    rootSize;
+        uint32_t    reserved;
+    };
+    static_assert(sizeof(FlatHeader)==32, "flat header is two alignment lines");
+
+    struct FlatFooter {
+        uint64_t    fixupOffset;
+        uint64_t    fixupCount;
+    };
+
+    #define FLAT_MAGIC      0x54414c46  // 'FLAT'
+    #define FLAT_VERSION    1
+
+    // hash of the data layout - field types and offsets, recursively. flags (const, ref etc) are not included
+    static uint64_t flat_mix ( uint64_t hash, uint64_t value ) {
+        return (hash ^ value) * 1099511628211ull;
+    }
+
+    static uint64_t flat_layout_hash ( TypeInfo * info, vector<StructInfo *> & stack, uint64_t hash = 14695981039346656037ull ) {
+        hash = flat_mix(hash, uint64_t(info->type));
+        hash = flat_mix(hash, info->dimSize);
+        for ( uint32_t i=0; i!=info->dimSize; ++i ) hash = flat_mix(hash, info->dim[i]);
+        if ( info->type==Type::tStructure && info->structType ) {
+            auto si = info->structType;
+            hash = flat_mix(hash, si->hash);
+            if ( find(stack.begin(), stack.end(), si)==stack.end() ) {
+                stack.push_back(si);
+                hash = flat_mix(hash, si->count);
+                for ( uint32_t i=0; i!=si->count; ++i ) {
+                    hash = flat_mix(hash, si->fields[i]->offset);
+                    hash = flat_layout_hash(si->fields[i], stack, hash);
+                }
+                stack.pop_back();
+            }
+        }
+        if ( info->firstType ) hash = flat_layout_hash(info->firstType, stack, hash);
+        if ( info->secondType ) hash = flat_layout_hash(info->secondType, stack, hash);
+        for ( uint32_t i=0; i!=info->argCount; ++i ) hash = flat_layout_hash(info->argTypes[i], stack, hash);
+        return hash;
+    }
+
+    static uint64_t flat_layout_hash ( TypeInfo * info ) {
+        vector<StructInfo *> stack;
+        return flat_layout_hash(info, stack);
+    }
+
+    struct FlatSink {
+        virtual ~FlatSink() {}
+        virtual void write ( const void * data, uint64_t size ) = 0;
+    };
+
+    struct FlatBufferSink : FlatSink {
+        Context *   context;
+        char *      bytesAt = nullptr;
+        uint64_t    bytesAllocated = 0;
+        uint64_t    bytesWritten = 0;
+        FlatBufferSink ( Context * ctx ) : context(ctx) {}
+        virtual void write ( const void * data, uint64_t size ) override {
+            if ( bytesWritten + size > bytesAllocated ) {
+                uint64_t newSize = das::max ( das::max(bytesAllocated * 2, uint64_t(4096)), bytesWritten + size );
+                if ( newSize > UINT32_MAX ) context->throw_error("flat image does not fit into an array");
+                bytesAt = context->reallocate(bytesAt, uint32_t(bytesAllocated), uint32_t(newSize));
+                if ( !bytesAt ) context->throw_out_of_memory(false, uint32_t(newSize));
+                context->heap->mark_comment(bytesAt, "flat serializer write");
+                bytesAllocated = newSize;
+            }
+            memcpy ( bytesAt + bytesWritten, data, size );
+            bytesWritten += size;
+        }
+    };
+
+    struct FlatFileSink : FlatSink {
+        Context *   context;
+        FILE *      file;
+        FlatFileSink ( Context * ctx, FILE * f ) : context(ctx), file(f) {}
+        virtual void write ( const void * data, uint64_t size ) override {
+            if ( size && fwrite(data, 1, size, file)!=size ) {
+                context->throw_error("flat serializer can't write to the file");
+            }
+        }
+    };
+
+    struct FlatDataWriter : DataWalker {
+        struct Pending {
+            char *      data;
+            TypeInfo *  info;           // element type, or null for the string
+            uint32_t    count;
+            uint32_t    stride;
+            uint64_t    offset;
+        };
+        FlatSink *          sink;
+        uint64_t            bytesWritten = 0;
+        uint64_t            bytesReserved = 0;
+        vector<Pending>     pending;
+        vector<uint64_t>    fixups;
+        vector<vec4f>       staging;
+        char *              blockData = nullptr;
+        uint64_t            blockOffset = 0;
+        FlatDataWriter ( Context & ctx, FlatSink * s ) : sink(s) {
+            context = &ctx;
+        }
+        void write ( const void * data, uint64_t size ) {
+            sink->write(data, size);
+            bytesWritten += size;
+        }
+        void pad ( uint64_t offset ) {
+            static const char zeros[16] = {};
+            while ( bytesWritten < offset ) {
+                write(zeros, das::min(offset - bytesWritten, uint64_t(sizeof(zeros))));
+            }
+        }
+        uint64_t reserve ( uint64_t size ) {
+            uint64_t offset = bytesReserved;
+            bytesReserved = (bytesReserved + size + 15) & ~uint64_t(15);
+            return offset;
+        }
+        void relocate ( char ** slot, char * data, TypeInfo * info, uint32_t count, uint32_t stride ) {
+            uint64_t offset = reserve(uint64_t(count) * stride);
+            pending.push_back({data, info, count, stride, offset});
+            fixups.push_back(blockOffset + uint64_t((char *)slot - blockData));
+            *slot = (char *) uintptr_t(offset);
+        }
+        // copy of the block, with pointers replaced by offsets
+        void writeBlock ( char * data, TypeInfo * info, uint32_t count, uint32_t stride, uint64_t offset ) {
+            pad(offset);
+            uint64_t size = uint64_t(count) * stride;
+            if ( !info || (info->flags & TypeInfo::flag_isRawPod) ) {
+                write(data, size);
+                return;
+            }
+            staging.resize((size + 15) / 16);
+            blockData = (char *) staging.data();
+            blockOffset = offset;
+            memcpy(blockData, data, size);
+            for ( uint32_t i=0; i!=count; ++i ) {
+                walk(blockData + i*stride, info);
+            }
+            write(blockData, size);
+        }
+        uint64_t save ( char * root, TypeInfo * info ) {
+            FlatHeader header;
+            header.magic = FLAT_MAGIC;
+            header.version = FLAT_VERSION;
+            header.hash = flat_layout_hash(info);
+            header.base = 0;
+            header.rootSize = getTypeSize(info);
+            header.reserved = 0;
+            write(&header, sizeof(header));
+            reserve(sizeof(header));
+            writeBlock(root, info, 1, header.rootSize, reserve(header.rootSize));
+            // pending list grows while we write
+            for ( size_t i=0; i!=pending.size(); ++i ) {
+                auto p = pending[i];
+                writeBlock(p.data, p.info, p.count, p.stride, p.offset);
+            }
+            FlatFooter footer;
+            footer.fixupOffset = reserve(0);
+            footer.fixupCount = fixups.size();
+            pad(footer.fixupOffset);
+            write(fixups.data(), fixups.size() * sizeof(uint64_t));
+            write(&footer, sizeof(footer));
+            return bytesWritten;
+        }
+    // data structures
+        virtual bool canVisitArray ( Array * pa, TypeInfo * ti ) override {
+            if ( pa->size ) {
+                relocate(&pa->data, pa->data, ti->firstType, pa->size, ti->firstType->size);
+            } else {
+                pa->data = nullptr;
+            }
+            pa->capacity = pa->size;
+            pa->lock = 1;       // arrays in the image can't be resized
+            pa->flags = 0;
+            return false;
+        }
+        virtual void beforeStructure ( char *, StructInfo * si ) override {
+            if ( si->flags & StructInfo::flag_class ) error("flat serialization of classes is not supported");
+        }
+        virtual void beforeTable ( Table *, TypeInfo * ) override {
+            error("flat serialization of tables is not supported");
+        }
+        virtual void beforePtr ( char *, TypeInfo * ) override {
+            error("flat serialization of pointers is not supported");
+        }
+        virtual void beforeHandle ( char *, TypeInfo * ) override {
+            error("flat serialization of handled types is not supported");
+        }
+        virtual void Null ( TypeInfo * ) override {
+            error("flat serialization of null pointers is not supported");
+        }
+        virtual void VoidPtr ( void * & ) override {
+            error("flat serialization of void pointers is not supported");
+        }
+        virtual void beforeIterator ( Sequence *, TypeInfo * ) override {
+            error("flat serialization of iterators is not supported");
+        }
+        virtual void WalkBlock ( Block * ) override {
+            error("flat serialization of blocks is not supported");
+        }
+        virtual void WalkFunction ( Func * ) override {
+            error("flat serialization of functions is not supported");
+        }
+        virtual void beforeLambda ( Lambda *, TypeInfo * ) override {
+            error("flat serialization of lambdas is not supported");
+        }
+        virtual void FakeContext ( Context * ) override {
+            error("flat serialization of context is not supported");
+        }
+    // types
+        virtual void String ( char * & data ) override {
+            if ( data ) {
+                auto length = uint32_t(strlen(data));
+                relocate(&data, data, nullptr, 1, length + 1);
+            }
+        }
+    };
+
+    // every array and string of the relocated image has to stay in front of the fixup table
+    struct FlatDataValidator : DataWalker {
+        char *      begin;
+        char *      end;
+        LineInfo *  at;
+        FlatDataValidator ( Context & ctx, char * b, char * e, LineInfo * a ) : begin(b), end(e), at(a) {
+            context = &ctx;
+        }
+        bool inside ( char * data ) const {
+            return begin<=data && data<end;
+        }
+        virtual bool canVisitArray ( Array * pa, TypeInfo * ti ) override {
+            if ( !pa->size ) return false;
+            if ( !inside(pa->data) || uint64_t(pa->size) * ti->firstType->size > uint64_t(end - pa->data) ) {
+                context->throw_error_at(at, "flat data array is out of range");
+            }
+            return !(ti->firstType->flags & TypeInfo::flag_isRawPod);
+        }
+        virtual void String ( char * & data ) override {
+            if ( data && (!inside(data) || !memchr(data, 0, end - data)) ) {
+                context->throw_error_at(at, "flat data string is out of range");
+            }
+        }
+    };
+
+    // fixup pointers in place, and return the root object
+    char * flat_relocate ( Context & context, TypeInfo * info, Array & arr, LineInfo * at ) {
+        uint64_t length = arr.size;
+        if ( length < sizeof(FlatHeader) + sizeof(FlatFooter) ) context.throw_error_at(at, "flat data is too short");
+        if ( uintptr_t(arr.data) & 15 ) context.throw_error_at(at, "flat data is not 16 bytes aligned");
+        auto header = (FlatHeader *) arr.data;
+        if ( header->magic!=FLAT_MAGIC || header->version!=FLAT_VERSION ) context.throw_error_at(at, "not a flat data");
+        if ( header->hash!=flat_layout_hash(info) || header->rootSize!=uint32_t(getTypeSize(info)) ) context.throw_error_at(at, "flat data type mismatch");
+        auto footer = (FlatFooter *) (arr.data + length - sizeof(FlatFooter));
+        if ( footer->fixupOffset < sizeof(FlatHeader) + header->rootSize
+            || footer->fixupCount > (length - sizeof(FlatFooter) - footer->fixupOffset) / sizeof(uint64_t) ) {
+            context.throw_error_at(at, "flat data is corrupted");
+        }
+        uintptr_t base = uintptr_t(arr.data);
+        if ( header->base != base ) {
+            auto fixups = (uint64_t *) (arr.data + footer->fixupOffset);
+            uintptr_t oldBase = uintptr_t(header->base);
+            for ( uint64_t i=0, is=footer->fixupCount; i!=is; ++i ) {
+                if ( fixups[i] > footer->fixupOffset - sizeof(char *) || (fixups[i] & (sizeof(char *) - 1)) ) {
+                    context.throw_error_at(at, "flat data fixup is out of range");
+                }
+                auto slot = (uintptr_t *) (arr.data + fixups[i]);
+                uintptr_t offset = *slot - oldBase;
+                if ( offset >= footer->fixupOffset ) context.throw_error_at(at, "flat data pointer is out of range");
+                *slot = base + offset;
+            }
+            FlatDataValidator validator(context, arr.data, arr.data + footer->fixupOffset, at);
+            validator.walk(arr.data + sizeof(FlatHeader), info);
+            header->base = base;
+        }
+        return arr.data + sizeof(FlatHeader);
+    }
+
+    // flat_save ( obj, block<(bytesAt)> )
+    vec4f _builtin_flat_save ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+        FlatBufferSink sink(&context);
+        FlatDataWriter writer(context, &sink);
+        Block * block = cast<Block *>::to(args[1]);
+        writer.save(cast<char *>::to(args[0]), call->types[0]);
+        Array arr;
+        arr.data = sink.bytesAt;
+        arr.size = uint32_t(sink.bytesWritten);
+        arr.capacity = uint32_t(sink.bytesAllocated);
+        arr.lock = 1;
+        arr.flags = 0;
+        vec4f arg = cast<char *>::from((char *)&arr);
+        context.invoke(*block, &arg, nullptr, &call->debugInfo);
+        context.free(sink.bytesAt, uint32_t(sink.bytesAllocated));
+        return v_zero();
+    }
+
+    // flat_save ( obj, file ) : bytes written
+    vec4f _builtin_flat_save_file ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+        FILE * file = cast<FILE *>::to(args[1]);
+        if ( !file ) context.throw_error_at(call->debugInfo, "can't flat_save to NULL file");
+        FlatFileSink sink(&context, file);
+        FlatDataWriter writer(context, &sink);
+        return cast<uint64_t>::from(writer.save(cast<char *>::to(args[0]), call->types[0]));
+    }
+
+    // flat_view ( type<T>, bytesAt, block<(obj:T)> )
+    vec4f _builtin_flat_view ( Context & context, SimNode_CallBase * call, vec4f * args ) {
+        Array * arr = cast<Array *>::to(args[1]);
+        Block * block = cast<Block *>::to(args[2]);
+        char * root = flat_relocate(context, call->types[0], *arr, &call->debugInfo);
+        vec4f arg = cast<char *>::from(root);
+        context.invoke(*block, &arg, nullptr, &call->debugInfo);
+        return v_zero();
+    }
+
     // save ( obj, block<(bytesAt)> )
     vec4f _builtin_binary_save ( Context & context, SimNode_CallBase * call, vec4f * args ) {
         BinDataSerialize writer(context);
@@ -695,6 +695,14 @@ namespace das
         }
     }
 
+    string LineInfo::describeInlined() const {
+        TextWriter ss;
+        for ( auto fi = fileInfo; fi && fi->getInlinedAt(); fi = fi->getInlinedAt()->fileInfo ) {
+            ss << ", inlined " << fi->getInlinedFunction() << " at " << fi->getInlinedAt()->describe();
+        }
+        return ss.str();
+    }
+
     bool LineInfo::operator < ( const LineInfo & info ) const {
         if ( fileInfo && info.fileInfo && fileInfo->name != info.fileInfo->name)
             return fileInfo->name<info.fileInfo->name;
@@ -742,6 +750,16 @@ namespace das
         len = sourceLength;
     }
 
+    InlinedFileInfo::InlinedFileInfo ( FileInfo * src, const string & fn, const LineInfo & at )
+            : source(src), function(fn), inlinedAt(at) {
+        name = src->name;
+        tabSize = src->tabSize;
+    }
+
+    void InlinedFileInfo::getSourceAndLength ( const char * & src, uint32_t & len ) {
+        source->getSourceAndLength(src, len);
+    }
+
     void TextFileInfo::freeSourceData() {
         if ( source ) {
             das_aligned_free16((void*)source);
@@ -3,6 +3,7 @@
 #include "daScript/simulate/simulate.h"
 #include "daScript/simulate/heap.h"
 #include "daScript/misc/debug_break.h"
+#include "daScript/misc/performance_time.h"
 
 namespace das {
 
@@ -15,6 +16,114 @@ namespace das {
     }
 #endif
 
+    ContextTenant::ContextTenant ( const string & n, uint64_t lim, uint64_t soft, const smart_ptr<ContextTenant> & p )
+        : name(n), parent(p), limit(lim), softLimit(soft) {
+    }
+
+    ContextTenant::~ContextTenant() {
+        DAS_ASSERTF(contexts.empty(), "tenant is destroyed while contexts are still using it");
+    }
+
+    bool ContextTenant::charge ( int64_t size, bool enforce ) {
+        for ( auto t = this; t; t = t->parent.get() ) {
+            int64_t was = t->bytes.fetch_add(size);
+            int64_t now = was + size;
+            if ( size<=0 ) continue;
+            if ( enforce && t->limit && uint64_t(now)>t->limit ) {
+                for ( auto r = this; r!=t; r = r->parent.get() ) r->bytes.fetch_sub(size);
+                t->bytes.fetch_sub(size);
+                t->failedAllocations ++;
+                return false;
+            }
+            int64_t peak = t->peakBytes;
+            while ( now>peak && !t->peakBytes.compare_exchange_weak(peak, now) ) {}
+            if ( t->softLimit && uint64_t(was)<=t->softLimit && uint64_t(now)>t->softLimit ) {
+                t->softLimitHits ++;
+                if ( t->onSoftLimit ) t->onSoftLimit(t);
+            }
+        }
+        if ( size>0 ) allocations ++;
+        return true;
+    }
+
+    ContextTenant * ContextTenant::overLimit ( int64_t size ) const {
+        ContextTenant * res = nullptr;
+        for ( auto t = (ContextTenant *) this; t; t = t->parent.get() ) {
+            if ( t->limit && uint64_t(t->bytes + size)>t->limit ) res = t;
+        }
+        return res;
+    }
+
+    void ContextTenant::addContext ( Context * ctx ) {
+        for ( auto t = this; t; t = t->parent.get() ) {
+            lock_guard<mutex> guard(t->contextsLock);
+            t->contexts.push_back(ctx);
+        }
+    }
+
+    void ContextTenant::removeContext ( Context * ctx ) {
+        for ( auto t = this; t; t = t->parent.get() ) {
+            lock_guard<mutex> guard(t->contextsLock);
+            auto it = find(t->contexts.begin(), t->contexts.end(), ctx);
+            if ( it!=t->contexts.end() ) t->contexts.erase(it);
+        }
+    }
+
+    // only contexts with threadlock_context can be safely found idle.
+    //  the allocating context is in the middle of an expression, its temporaries are not visible to the collector
+    int32_t ContextTenant::collectIdle ( Context * except ) {
+        int32_t total = 0;
+        lock_guard<mutex> guard(contextsLock);
+        for ( auto ctx : contexts ) {
+            if ( ctx==except || !ctx->contextMutex ) continue;
+            if ( !ctx->contextMutex->try_lock() ) continue;
+            if ( ctx->insideContext==0 ) {
+                ctx->collectHeap(nullptr, true, false);
+                if ( auto t = ctx->heap->getTenant() ) t->collections ++;
+                total ++;
+            }
+            ctx->contextMutex->unlock();
+        }
+        return total;
+    }
+
+    void ContextTenant::startBudget ( uint64_t usec ) {
+        timeBudgetUsec = usec;
+        budgetStart = ref_time_ticks();
+        lock_guard<mutex> guard(contextsLock);
+        for ( auto ctx : contexts ) {
+            ctx->clearStopForBudget();
+        }
+    }
+
+    bool ContextTenant::checkBudget() {
+        if ( !timeBudgetUsec || uint64_t(get_time_usec(budgetStart))<=timeBudgetUsec ) return false;
+        stop();
+        return true;
+    }
+
+    // running contexts unwind at the next statement, and Context::call reports it as an exception
+    void ContextTenant::stop() {
+        lock_guard<mutex> guard(contextsLock);
+        for ( auto ctx : contexts ) {
+            ctx->setStopForBudget();
+        }
+    }
+
+    void AnyHeapAllocator::setTenant ( ContextTenant * t ) {
+        if ( tenant ) tenant->charge(-tenantBytes, false);
+        tenant = t;
+        tenantBytes = 0;
+        syncTenant();
+    }
+
+    void AnyHeapAllocator::syncTenant() {
+        if ( !tenant ) return;
+        int64_t delta = int64_t(bytesAllocated()) - tenantBytes;
+        tenant->charge(delta, false);   // this memory is already there, so the limit does not apply
+        tenantBytes += delta;
+    }
+
     char * AnyHeapAllocator::impl_allocateIterator ( uint32_t size, const char * name, const LineInfo * info ) {
         char * data = impl_allocate(size + 16);
         if ( !data ) return nullptr;
@@ -155,6 +264,209 @@ namespace das {
         }
     }
 
+    NurseryHeapAllocator::NurseryHeapAllocator ( const smart_ptr<AnyHeapAllocator> & o, uint32_t size ) : old(o) {
+        DAS_ASSERT(old && !old->asNursery());
+        regionSize = (size + 15) & ~15;
+        region = regionSize ? (char *) das_aligned_alloc16(regionSize) : nullptr;
+    }
+
+    NurseryHeapAllocator::~NurseryHeapAllocator() {
+        for ( auto & rr : retired ) das_aligned_free16(rr.first);
+        if ( region ) das_aligned_free16(region);
+    }
+
+    // the old heap has no tenant, nursery charges for both
+    char * NurseryHeapAllocator::impl_allocate ( uint32_t size ) {
+        if ( limit!=0 && bytesAllocated()+size>limit ) return nullptr;
+        if ( !tenantCharge(size) ) return nullptr;
+        uint32_t asize = (max(size,1u) + 15) & ~15;
+        if ( regionSize-top < asize ) {
+            auto ptr = old->impl_allocate(size);
+            if ( !ptr ) tenantCharge(-int64_t(size));
+            return ptr;
+        }
+        totalAllocations ++;
+        totalBytesAllocated += size;
+        char * ptr = region + top;
+        offsets.push_back(top);
+        sizes.push_back(asize);
+        top += asize;
+        return ptr;
+    }
+
+    void NurseryHeapAllocator::impl_free ( char * ptr, uint32_t size ) {
+        tenantCharge(-int64_t(size));
+        if ( !isYoung(ptr) ) {
+            if ( !isRetired(ptr) ) old->impl_free(ptr, size);
+            return;
+        }
+        totalBytesDeleted += size;
+        // only the last allocation can be given back, the rest waits for the minor collection
+        if ( region+offsets.back()==ptr ) {
+            top = offsets.back();
+            offsets.pop_back();
+            sizes.pop_back();
+        }
+    }
+
+    char * NurseryHeapAllocator::impl_reallocate ( char * ptr, uint32_t oldSize, uint32_t newSize ) {
+        if ( !isYoung(ptr) ) {
+            if ( !isRetired(ptr) ) {
+                if ( limit!=0 && bytesAllocated()+newSize-oldSize>limit ) return nullptr;
+                if ( !tenantCharge(int64_t(newSize)-int64_t(oldSize)) ) return nullptr;
+                auto nptr = old->impl_reallocate(ptr, oldSize, newSize);
+                if ( !nptr ) tenantCharge(int64_t(oldSize)-int64_t(newSize));
+                return nptr;
+            }
+        } else if ( region+offsets.back()==ptr ) {
+            // last allocation grows (or shrinks) in place
+            uint32_t asize = (max(newSize,1u) + 15) & ~15;
+            if ( offsets.back()+asize <= regionSize ) {
+                if ( limit!=0 && bytesAllocated()+newSize-oldSize>limit ) return nullptr;
+                if ( !tenantCharge(int64_t(newSize)-int64_t(oldSize)) ) return nullptr;
+                totalAllocations ++;
+                totalBytesAllocated += newSize-oldSize;
+                top = offsets.back() + asize;
+                sizes.back() = asize;
+                return ptr;
+            }
+        }
+        char * nptr = impl_allocate(newSize);
+        if ( !nptr ) return nullptr;
+        memcpy(nptr, ptr, min(oldSize,newSize));
+        impl_free(ptr, oldSize);
+        return nptr;
+    }
+
+    uint64_t NurseryHeapAllocator::totalAlignedMemoryAllocated() const {
+        return old->totalAlignedMemoryAllocated() + uint64_t(regionSize) * (retired.size() + 1);
+    }
+
+    void NurseryHeapAllocator::reset() {
+        for ( auto & rr : retired ) das_aligned_free16(rr.first);
+        retired.clear();
+        retiredBytes = 0;
+        top = 0;
+        offsets.clear();
+        sizes.clear();
+        old->reset();
+    }
+
+    void NurseryHeapAllocator::report() {
+        LOG tout(LogLevel::debug);
+        tout << "nursery " << top << " of " << regionSize << " in " << uint64_t(offsets.size()) << " allocations, "
+            << uint64_t(retired.size()) << " retired regions\n";
+        tout << "minor collections " << minorCollections << ", promoted " << bytesPromoted
+            << ", reclaimed " << bytesReclaimed << ", max pause " << maxPauseUsec << " usec\n";
+        old->report();
+    }
+
+    bool NurseryHeapAllocator::mark() {
+        markedYoung.clear();
+        return old->mark();
+    }
+
+    bool NurseryHeapAllocator::mark ( char * ptr, uint32_t size ) {
+        if ( isYoung(ptr) || isRetired(ptr) ) {
+            return markedYoung.insert(ptr).second;
+        }
+        return old->mark(ptr, size);
+    }
+
+    int32_t NurseryHeapAllocator::findRetired ( char * ptr ) const {
+        auto it = upper_bound(retired.begin(), retired.end(), ptr, [](char * p, const pair<char *,uint32_t> & rr) {
+            return p < rr.first;
+        });
+        if ( it==retired.begin() ) return -1;
+        --it;
+        return ptr < it->first + it->second ? int32_t(it - retired.begin()) : -1;
+    }
+
+    // full collection marked everything reachable, retired region with no marks in it is garbage as a whole
+    void NurseryHeapAllocator::sweep() {
+        old->sweep();
+        if ( retired.empty() ) return;
+        vector<uint8_t> live(retired.size(), 0);
+        for ( auto ptr : markedYoung ) {
+            auto idx = findRetired(ptr);
+            if ( idx>=0 ) live[idx] = 1;
+        }
+        markedYoung.clear();
+        size_t kept = 0;
+        for ( size_t i=0, is=retired.size(); i!=is; ++i ) {
+            if ( live[i] ) {
+                retired[kept++] = retired[i];
+            } else {
+                retiredBytes -= retired[i].second;
+                das_aligned_free16(retired[i].first);
+                regionsFreed ++;
+            }
+        }
+        retired.resize(kept);
+    }
+
+    int32_t NurseryHeapAllocator::findAllocation ( char * ptr ) const {
+        if ( !isYoung(ptr) ) return -1;
+        uint32_t ofs = uint32_t(ptr - region);
+        auto it = upper_bound(offsets.begin(), offsets.end(), ofs);
+        return int32_t(it - offsets.begin()) - 1;
+    }
+
+    char * NurseryHeapAllocator::translate ( char * ptr, const vector<char *> & forward ) const {
+        auto idx = findAllocation(ptr);
+        if ( idx<0 ) return ptr;
+        DAS_ASSERTF(forward[idx], "young allocation was not promoted");
+        return forward[idx] + (ptr - (region + offsets[idx]));
+    }
+
+    bool NurseryHeapAllocator::evacuate ( const vector<uint8_t> & live, const vector<char **> & fixups, const callable<void (char *, char *)> & moved ) {
+        DAS_ASSERT(live.size()==offsets.size());
+        vector<char *> forward(offsets.size(), nullptr);
+        uint64_t promoted = 0;
+        for ( size_t i=0, is=offsets.size(); i!=is; ++i ) {
+            if ( !live[i] ) continue;
+            char * nptr = old->impl_allocate(sizes[i]);
+            if ( !nptr ) {
+                // old heap is out of memory, undo and keep the region
+                for ( size_t j=0; j!=i; ++j ) {
+                    if ( forward[j] ) old->impl_free(forward[j], sizes[j]);
+                }
+                return false;
+            }
+            memcpy(nptr, region + offsets[i], sizes[i]);
+            forward[i] = nptr;
+            promoted += sizes[i];
+        }
+        // the original young memory is intact at this point, so every location is read from there
+        for ( auto loc : fixups ) {
+            auto target = (char **) translate((char *)loc, forward);
+            *target = translate(*loc, forward);
+        }
+        for ( size_t i=0, is=offsets.size(); i!=is; ++i ) {
+            if ( forward[i] ) moved(region + offsets[i], forward[i]);
+        }
+        bytesPromoted += promoted;
+        bytesReclaimed += top - promoted;
+        top = 0;
+        offsets.clear();
+        sizes.clear();
+        return true;
+    }
+
+    void NurseryHeapAllocator::retire() {
+        if ( !top ) return;
+        auto at = upper_bound(retired.begin(), retired.end(), region, [](char * p, const pair<char *,uint32_t> & rr) {
+            return p < rr.first;
+        });
+        retired.insert(at, make_pair(region, top));
+        retiredBytes += top;
+        regionsRetired ++;
+        region = (char *) das_aligned_alloc16(regionSize);
+        top = 0;
+        offsets.clear();
+        sizes.clear();
+    }
+
     void StringHeapAllocator::setIntern(bool on) {
         needIntern = on;
         if ( !needIntern ) {
@@ -367,4 +679,12 @@ namespace das {
         stringBytes += bytes;
         return nname;
     }
+
+#if DAS_COMPACT_DEBUG_INFO
+    DAS_THREAD_LOCAL DebugInfoAllocator * g_nodeLineInfoTable = nullptr;
+
+    LineInfo * DebugInfoAllocator::makeNodeLineInfo ( const LineInfo & at ) {
+        return new (lineInfo.allocate(sizeof(LineInfo))) LineInfo(at);
+    }
+#endif
 }
@@ -0,0 +1,254 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/simulate/heap_sampler.h"
+#include "daScript/simulate/debug_info.h"
+
+namespace das
+{
+    HeapSampler::HeapSampler ( uint64_t rate, int32_t depth ) {
+        sampleRate = rate ? rate : 1;
+        maxDepth = depth>0 ? depth : 1;
+        rng = 0x9E3779B97F4A7C15ull ^ uint64_t(intptr_t(this));
+        bytesUntilSample = int64_t(nextSampleDistance());
+    }
+
+    // exponentially distributed distance between samples, with sampleRate mean
+    uint64_t HeapSampler::nextSampleDistance() {
+        if ( sampleRate==1 ) return 0;
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        double u = double((rng >> 11) + 1) * (1.0 / 9007199254740993.0);  // (0,1]
+        return uint64_t(-log(u) * double(sampleRate)) + 1;
+    }
+
+    uint32_t HeapSampler::captureSite ( Context * context, const LineInfo & at ) {
+        vector<Frame> stack;
+        const LineInfo * lineAt = &at;
+#if DAS_ENABLE_STACK_WALK
+        char * sp = context->stack.ap();
+        while ( sp < context->stack.top() && int32_t(stack.size()) < maxDepth ) {
+            Prologue * pp = (Prologue *) sp;
+            FuncInfo * info = nullptr;
+            if ( pp->info ) {
+                intptr_t iblock = intptr_t(pp->block);
+                info = (iblock & 1) ? ((Block *) (iblock & ~1))->info : pp->info;
+            }
+            Frame frame;
+            frame.function = info ? info->name : pp->fileName;
+            if ( lineAt ) frame.at = *lineAt;
+            stack.push_back(frame);
+            lineAt = info ? pp->line : nullptr;
+            sp += info ? info->stackSize : pp->stackSize;
+        }
+#else
+        (void) context;
+#endif
+        if ( stack.empty() ) {
+            Frame frame;
+            frame.at = at;
+            stack.push_back(frame);
+        }
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&]( uint64_t value ) { hash = (hash ^ value) * 1099511628211ull; };
+        for ( auto & frame : stack ) {
+            mix(uint64_t(intptr_t(frame.function)));
+            mix(uint64_t(intptr_t(frame.at.fileInfo)));
+            mix(frame.at.line);
+            mix(frame.at.column);
+        }
+        auto it = siteLookup.find(hash);
+        if ( it!=siteLookup.end() ) return it->second;
+        uint32_t siteId = uint32_t(sites.size());
+        sites.emplace_back();
+        sites.back().stack = das::move(stack);
+        siteLookup[hash] = siteId;
+        return siteId;
+    }
+
+    void HeapSampler::onAllocate ( Context * context, void * ptr, uint64_t size, const LineInfo & at ) {
+        if ( !ptr ) return;
+        bytesUntilSample -= int64_t(size);
+        if ( bytesUntilSample > 0 ) return;
+        bytesUntilSample = int64_t(nextSampleDistance());
+        Sample sample;
+        sample.site = captureSite(context, at);
+        sample.size = size;
+        sample.weight = sampleRate==1 ? 1. : 1. / (1. - exp(-double(size) / double(sampleRate)));
+        auto & site = sites[sample.site];
+        site.allocCount ++;
+        site.allocBytes += size;
+        site.allocWeight += sample.weight;
+        site.allocWeightBytes += sample.weight * double(size);
+        samples[ptr] = sample;
+    }
+
+    void HeapSampler::onReallocate ( Context * context, void * ptr, uint64_t, void * newPtr, uint64_t newSize, const LineInfo & at ) {
+        onFree(ptr);
+        onAllocate(context, newPtr, newSize, at);
+    }
+
+    void HeapSampler::onFree ( void * ptr ) {
+        samples.erase(ptr);
+    }
+
+    void HeapSampler::onMove ( void * ptr, void * newPtr ) {
+        auto it = samples.find(ptr);
+        if ( it==samples.end() ) return;
+        auto sample = it->second;
+        samples.erase(it);
+        samples[newPtr] = sample;
+    }
+
+    void HeapSampler::prune ( const callable<bool (void *, uint64_t)> & isLive ) {
+        for ( auto it = samples.begin(); it!=samples.end(); ) {
+            if ( isLive(it->first, it->second.size) ) {
+                ++it;
+            } else {
+                it = samples.erase(it);
+            }
+        }
+    }
+
+    void HeapSampler::reset() {
+        samples.clear();
+    }
+
+    HeapSampler::Snapshot HeapSampler::live() const {
+        Snapshot snap;
+        for ( auto & it : samples ) {
+            auto & st = snap[it.second.site];
+            st.count ++;
+            st.bytes += it.second.size;
+            st.weight += it.second.weight;
+            st.weightBytes += it.second.weight * double(it.second.size);
+        }
+        return snap;
+    }
+
+    int32_t HeapSampler::snapshot() {
+        snapshots.push_back(live());
+        return int32_t(snapshots.size()) - 1;
+    }
+
+    const HeapSampler::Snapshot * HeapSampler::getSnapshot ( int32_t index ) const {
+        return (index>=0 && index<int32_t(snapshots.size())) ? &snapshots[index] : nullptr;
+    }
+
+    // growth from 'from' to 'to', only sites which grew
+    HeapSampler::Snapshot HeapSampler::diff ( const Snapshot & from, const Snapshot & to ) const {
+        Snapshot res;
+        for ( auto & it : to ) {
+            SiteStat st = it.second;
+            auto ft = from.find(it.first);
+            if ( ft!=from.end() ) {
+                if ( st.weightBytes <= ft->second.weightBytes ) continue;
+                st.count = st.count > ft->second.count ? st.count - ft->second.count : 0;
+                st.bytes = st.bytes > ft->second.bytes ? st.bytes - ft->second.bytes : 0;
+                st.weight -= ft->second.weight;
+                st.weightBytes -= ft->second.weightBytes;
+            }
+            res[it.first] = st;
+        }
+        return res;
+    }
+
+    string HeapSampler::describeSite ( uint32_t siteId ) const {
+        TextWriter tw;
+        for ( auto & frame : sites[siteId].stack ) {
+            tw << "\t\t" << (frame.function ? frame.function : "?") << " at " << frame.at.describe() << "\n";
+        }
+        return tw.str();
+    }
+
+    void HeapSampler::reportStats ( TextWriter & tw, const Snapshot & snap, int32_t topN, const char * title ) const {
+        vector<pair<uint32_t,SiteStat>> sorted(snap.begin(), snap.end());
+        double totalBytes = 0., totalCount = 0.;
+        for ( auto & it : sorted ) {
+            totalBytes += it.second.weightBytes;
+            totalCount += it.second.weight;
+        }
+        stable_sort(sorted.begin(), sorted.end(), [](auto & a, auto & b){
+            return a.second.weightBytes > b.second.weightBytes;
+        });
+        tw << title << ", sample rate " << sampleRate << " bytes, estimated "
+            << uint64_t(totalBytes) << " bytes in " << uint64_t(totalCount) << " allocations\n";
+        for ( int32_t i=0, is=min(topN,int32_t(sorted.size())); i!=is; ++i ) {
+            auto & st = sorted[i].second;
+            tw << "\t" << uint64_t(st.weightBytes) << " bytes in " << uint64_t(st.weight) << " allocations ("
+                << st.count << " samples)\n" << describeSite(sorted[i].first);
+        }
+    }
+
+    void HeapSampler::report ( TextWriter & tw, int32_t topN ) const {
+        reportStats(tw, live(), topN, "live heap");
+    }
+
+    void HeapSampler::reportDiff ( TextWriter & tw, int32_t fromIndex, int32_t toIndex, int32_t topN ) const {
+        auto from = getSnapshot(fromIndex);
+        if ( !from ) {
+            tw << "invalid heap snapshot " << fromIndex << "\n";
+            return;
+        }
+        Snapshot current;
+        auto to = toIndex==-1 ? &(current = live()) : getSnapshot(toIndex);
+        if ( !to ) {
+            tw << "invalid heap snapshot " << toIndex << "\n";
+            return;
+        }
+        reportStats(tw, diff(*from, *to), topN, "heap growth");
+    }
+
+    // legacy gperftools heap profile, with embedded symbols (readable by pprof)
+    //  frames get synthetic addresses, symbol of each address is 'function file:line'
+    //  counts are raw samples, heap_v2 tells pprof to unsample them with the sample rate
+    void HeapSampler::writePprof ( TextWriter & tw, int32_t index, int32_t baseIndex ) const {
+        Snapshot current;
+        auto snap = index==-1 ? &(current = live()) : getSnapshot(index);
+        if ( !snap ) return;
+        Snapshot growth;
+        if ( baseIndex!=-1 ) {
+            auto base = getSnapshot(baseIndex);
+            if ( !base ) return;
+            growth = diff(*base, *snap);
+            snap = &growth;
+        }
+        das_map<string,uint64_t> symbols;
+        das_hash_map<uint32_t,vector<uint64_t>> addresses;
+        for ( auto & it : *snap ) {
+            auto & addr = addresses[it.first];
+            for ( auto & frame : sites[it.first].stack ) {
+                string sym = string(frame.function ? frame.function : "?") + " " + frame.at.describe();
+                auto st = symbols.find(sym);
+                if ( st==symbols.end() ) {
+                    st = symbols.insert(make_pair(sym, uint64_t(0x1000 + symbols.size()*16))).first;
+                }
+                addr.push_back(st->second);
+            }
+        }
+        tw << "--- symbol\nbinary=daScript\n";
+        for ( auto & it : symbols ) {
+            tw << "0x" << HEX << it.second << DEC << " " << it.first << "\n";
+        }
+        tw << "---\n--- heap\n";
+        uint64_t inuseCount = 0, inuseBytes = 0, allocCount = 0, allocBytes = 0;
+        for ( auto & it : *snap ) {
+            inuseCount += it.second.count;
+            inuseBytes += it.second.bytes;
+            allocCount += baseIndex!=-1 ? it.second.count : sites[it.first].allocCount;
+            allocBytes += baseIndex!=-1 ? it.second.bytes : sites[it.first].allocBytes;
+        }
+        tw << "heap profile: " << inuseCount << ": " << inuseBytes << " [" << allocCount << ": " << allocBytes
+            << "] @ heap_v2/" << sampleRate << "\n";
+        for ( auto & it : *snap ) {
+            auto & site = sites[it.first];
+            tw << it.second.count << ": " << it.second.bytes << " ["
+                << (baseIndex!=-1 ? it.second.count : site.allocCount) << ": "
+                << (baseIndex!=-1 ? it.second.bytes : site.allocBytes) << "] @";
+            for ( auto addr : addresses[it.first] ) {
+                tw << " 0x" << HEX << addr << DEC;
+            }
+            tw << "\n";
+        }
+    }
+}
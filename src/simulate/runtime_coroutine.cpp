@@ -0,0 +1,166 @@
+#include "daScript/misc/platform.h"
+
+#include "daScript/simulate/runtime_coroutine.h"
+#include "daScript/simulate/aot_builtin.h"
+
+namespace das
+{
+    // scheduler, which is resuming coroutines on this thread
+    static DAS_THREAD_LOCAL CoroutineScheduler * g_currentScheduler = nullptr;
+
+    CoroutineScheduler::~CoroutineScheduler() {
+        DAS_ASSERTF(runQueue.empty() && totalWaiting==0, "coroutine scheduler needs to be cleared before it is deleted");
+        for ( auto chunk : frameChunks ) {
+            delete [] chunk;
+        }
+    }
+
+    CoroutineScheduler::Frames * CoroutineScheduler::allocFrames() {
+        if ( framePool.empty() ) {
+            auto chunk = new Frames[framesPerChunk];
+            frameChunks.push_back(chunk);
+            for ( int32_t i=framesPerChunk; i--; ) {
+                framePool.push_back(chunk + i);
+            }
+        }
+        auto frames = framePool.back();
+        framePool.pop_back();
+        return frames;
+    }
+
+    void CoroutineScheduler::freeFrames ( Frames * frames ) {
+        frames->root.iter = nullptr;
+        frames->deep.clear();
+        frames->depth = 0;
+        framePool.push_back(frames);
+    }
+
+    void CoroutineScheduler::add ( Context *, Sequence & it ) {
+        if ( !it.iter ) return;
+        Coroutine co;
+        co.frames = allocFrames();
+        co.frames->root = it;
+        co.frames->push(&co.frames->root);
+        it.iter = nullptr;
+        runQueue.push_back(co);
+    }
+
+    void CoroutineScheduler::close ( Context * context, Coroutine & co ) {
+        // sub-coroutines are owned by the awaiting ones, and go away with the root
+        builtin_iterator_delete(co.frames->root, context);
+        freeFrames(co.frames);
+        co.frames = nullptr;
+    }
+
+    CoroutineScheduler::Status CoroutineScheduler::resume ( Context * context, Coroutine & co ) {
+        auto & frames = *co.frames;
+        for ( ;; ) {
+            bool value = true;
+            clearRequest();
+            bool alive = builtin_iterator_iterate(*frames.top(), &value, context);
+            if ( alive && !value ) {
+                // the frame asked for the transfer at its yield site
+                if ( pendingAwait ) {
+                    // sub-coroutine runs in place of the awaiting one, right away
+                    frames.push(pendingAwait);
+                    clearRequest();
+                    continue;
+                } else if ( hasPendingEvent ) {
+                    co.event = pendingEvent;
+                    clearRequest();
+                    return Status::waiting;
+                }
+            }
+            clearRequest();
+            if ( alive ) return Status::running;
+            if ( frames.depth==1 ) return Status::done;
+            frames.pop();
+            // awaiting coroutine continues after its co_await, and finds the sub-coroutine empty
+        }
+    }
+
+    bool CoroutineScheduler::tick ( Context * context ) {
+        auto saved = g_currentScheduler;
+        g_currentScheduler = this;
+        // coroutines, which are added while ticking, are resumed on the next tick
+        size_t total = runQueue.size(), keep = 0, index = 0;
+        bool ok = context->runWithCatch([&](){
+            for ( ; index!=total; ++index ) {
+                auto co = runQueue[index];
+                switch ( resume(context, co) ) {
+                case Status::running:
+                    runQueue[keep++] = co;
+                    break;
+                case Status::waiting:
+                    waitQueue[co.event].push_back(co);
+                    totalWaiting ++;
+                    break;
+                case Status::done:
+                    freeFrames(co.frames);
+                    break;
+                }
+            }
+        });
+        clearRequest();
+        g_currentScheduler = saved;
+        if ( !ok ) {
+            // coroutine which threw is dropped, the rest stays scheduled
+            close(context, runQueue[index]);
+            for ( ++index; index!=total; ++index ) {
+                runQueue[keep++] = runQueue[index];
+            }
+        }
+        runQueue.erase(runQueue.begin() + keep, runQueue.begin() + total);
+        if ( !ok ) context->rethrow();
+        return !runQueue.empty() || totalWaiting!=0;
+    }
+
+    int32_t CoroutineScheduler::signal ( int32_t event ) {
+        auto it = waitQueue.find(event);
+        if ( it==waitQueue.end() ) return 0;
+        int32_t count = int32_t(it->second.size());
+        runQueue.insert(runQueue.end(), it->second.begin(), it->second.end());
+        totalWaiting -= count;
+        waitQueue.erase(it);
+        return count;
+    }
+
+    void CoroutineScheduler::clear ( Context * context ) {
+        for ( auto & co : runQueue ) {
+            close(context, co);
+        }
+        runQueue.clear();
+        for ( auto & it : waitQueue ) {
+            for ( auto & co : it.second ) {
+                close(context, co);
+            }
+        }
+        waitQueue.clear();
+        totalWaiting = 0;
+        clearRequest();
+        if ( g_currentScheduler==this ) g_currentScheduler = nullptr;
+    }
+
+    bool CoroutineScheduler::transfer ( Sequence & it ) {
+        auto sched = g_currentScheduler;
+        if ( !sched || !it.iter ) return false;
+        sched->clearRequest();
+        sched->pendingAwait = &it;
+        return true;
+    }
+
+    bool CoroutineScheduler::wait ( int32_t event ) {
+        auto sched = g_currentScheduler;
+        if ( !sched ) return false;
+        sched->clearRequest();
+        sched->pendingEvent = event;
+        sched->hasPendingEvent = true;
+        return true;
+    }
+
+    void CoroutineScheduler::resumed() {
+        if ( auto sched = g_currentScheduler ) {
+            sched->clearRequest();
+        }
+    }
+}
@@ -342,14 +342,95 @@ namespace das
         return ssw.str();
     }
 
-    vec4f SimNode_StringBuilder::eval ( Context & context ) {
-        DAS_PROFILE_NODE
-        vec4f * argValues = (vec4f *)(alloca(nArguments * sizeof(vec4f)));
-        evalArgs(context, argValues);
+    // string builder
+
+    template <typename TT>
+    static __forceinline uint32_t sb_format_decimal ( char * out, TT value ) {
+        typedef typename std::make_unsigned<TT>::type UT;
+        char buf[24];
+        char * at = buf + sizeof(buf);
+        UT uv = value<0 ? UT(0) - UT(value) : UT(value);
+        do {
+            *--at = char('0' + uv % 10);
+            uv /= 10;
+        } while ( uv );
+        if ( value<0 ) *--at = '-';
+        uint32_t length = uint32_t(buf + sizeof(buf) - at);
+        memcpy(out, at, length);
+        return length;
+    }
+
+    template <typename TT>
+    static __forceinline uint32_t sb_format_hex ( char * out, TT value ) {
+        char buf[24];
+        char * at = buf + sizeof(buf);
+        do {
+            *--at = "0123456789abcdef"[value & 15];
+            value >>= 4;
+        } while ( value );
+        *--at = 'x';
+        *--at = '0';
+        uint32_t length = uint32_t(buf + sizeof(buf) - at);
+        memcpy(out, at, length);
+        return length;
+    }
+
+    static __forceinline uint32_t sb_format_float ( char * out, uint32_t size, const char * fmt, double value ) {
+        int length = snprintf(out, size, fmt, value);
+        return length>0 ? uint32_t(length) : 0;
+    }
+
+    uint32_t getStringBuilderScratchSize ( StringBuilderFormat format ) {
+        switch ( format ) {
+            case StringBuilderFormat::int32:    return 12;
+            case StringBuilderFormat::hex32:    return 11;
+            case StringBuilderFormat::int64:    return 21;
+            case StringBuilderFormat::hex64:    return 19;
+            case StringBuilderFormat::float32:  return 64;      // "%.9f" of FLT_MAX is 50 characters
+            case StringBuilderFormat::float64:  return 336;     // "%.17f" of DBL_MAX is 328 characters
+            default:                            return 0;
+        }
+    }
+
+    // same text, as DebugDataWalker with PrintFlags::string_builder would produce
+    static __forceinline uint32_t sb_format ( const StringBuilderSegment & seg, vec4f value, char * scratch, const char * & text ) {
+        text = scratch;
+        switch ( seg.format ) {
+            case StringBuilderFormat::literal:  text = seg.text; return seg.length;
+            case StringBuilderFormat::boolean:
+                if ( cast<bool>::to(value) ) {
+                    text = "true";
+                    return 4;
+                } else {
+                    text = "false";
+                    return 5;
+                }
+            case StringBuilderFormat::int32:    return sb_format_decimal(scratch, cast<int32_t>::to(value));
+            case StringBuilderFormat::hex32:    return sb_format_hex(scratch, cast<uint32_t>::to(value));
+            case StringBuilderFormat::int64:    return sb_format_decimal(scratch, cast<int64_t>::to(value));
+            case StringBuilderFormat::hex64:    return sb_format_hex(scratch, cast<uint64_t>::to(value));
+            case StringBuilderFormat::float32:  return sb_format_float(scratch, 64, "%.9f", cast<float>::to(value));
+            case StringBuilderFormat::float64:  return sb_format_float(scratch, 336, "%.17f", cast<double>::to(value));
+            case StringBuilderFormat::string:
+                text = cast<char *>::to(value);
+                return text ? uint32_t(strlen(text)) : 0;
+            default:                            return 0;
+        }
+    }
+
+    char * SimNode_StringBuilder::walkString ( Context & context, vec4f * argValues ) {
         StringBuilderWriter writer;
         DebugDataWalker<StringBuilderWriter> walker(writer, PrintFlags::string_builder);
+        char scratch[336];
         for ( int i=0, is=nArguments; i!=is; ++i ) {
-            walker.walk(argValues[i], types[i]);
+            if ( !segments || segments[i].format==StringBuilderFormat::walk ) {
+                walker.walk(argValues[i], types[i]);
+            } else {
+                const char * text = nullptr;
+                if ( auto length = sb_format(segments[i], argValues[i], scratch, text) ) {
+                    writer.writeStr(text, length);
+                }
+            }
         }
         uint64_t length = writer.tellp();
         if ( length ) {
@@ -357,11 +438,66 @@ namespace das
             if ( !pStr  ) {
                 context.throw_out_of_memory(true, uint32_t(length), &debugInfo);
             }
-            if ( isTempString ) context.freeTempString(pStr, &debugInfo);
-            return cast<char *>::from(pStr);
+            return pStr;
         } else {
-            return v_zero();
+            return nullptr;
+        }
+    }
+
+    char * SimNode_StringBuilder::buildString ( Context & context, vec4f * argValues ) {
+        if ( !segments || hasWalk ) return walkString(context, argValues);
+        // format numbers into the scratch buffer, then write the exact length string in place
+        char * scratch = (char *)(alloca(scratchSize + 1));
+        const char ** texts = (const char **)(alloca(nArguments * sizeof(const char *)));
+        uint32_t * lengths = (uint32_t *)(alloca(nArguments * sizeof(uint32_t)));
+        uint64_t length = 0;
+        for ( int i=0, is=nArguments; i!=is; ++i ) {
+            lengths[i] = sb_format(segments[i], argValues[i], scratch, texts[i]);
+            if ( texts[i]==scratch ) scratch += lengths[i];
+            length += lengths[i];
+        }
+        if ( !length ) return nullptr;
+        auto pStr = context.allocateString(nullptr, uint32_t(length), &debugInfo);
+        if ( !pStr ) {
+            context.throw_out_of_memory(true, uint32_t(length), &debugInfo);
+        }
+        char * at = pStr;
+        for ( int i=0, is=nArguments; i!=is; ++i ) {
+            if ( lengths[i] ) {
+                memcpy(at, texts[i], lengths[i]);
+                at += lengths[i];
+            }
+        }
+        if ( context.stringHeap->isIntern() ) context.stringHeap->recognize(pStr);
+        return pStr;
+    }
+
+    vec4f SimNode_StringBuilder::eval ( Context & context ) {
+        DAS_PROFILE_NODE
+        vec4f * argValues = (vec4f *)(alloca(nArguments * sizeof(vec4f)));
+        if ( segments ) {
+            for ( int i=0, is=nArguments; i!=is && !context.stopFlags; ++i ) {
+                auto format = segments[i].format;
+                if ( format!=StringBuilderFormat::skip && format!=StringBuilderFormat::literal ) {
+                    argValues[i] = arguments[i]->eval(context);
+                }
+            }
+        } else {
+            evalArgs(context, argValues);
+        }
+        auto pStr = buildString(context, argValues);
+        if ( pStr && isTempString ) context.freeTempString(pStr, &debugInfo);
+        return cast<char *>::from(pStr);
+    }
+
+    SimNode * SimNode_StringBuilder::copyNode ( Context & context, NodeAllocator * code ) {
+        SimNode_StringBuilder * that = (SimNode_StringBuilder *) SimNode_CallBase::copyNode(context, code);
+        if ( segments ) {
+            auto newSegments = (StringBuilderSegment *) code->allocate(nArguments * sizeof(StringBuilderSegment));
+            memcpy ( newSegments, that->segments, nArguments * sizeof(StringBuilderSegment));
+            that->segments = newSegments;
         }
+        return that;
     }
 
     // string iteration
@@ -4,6 +4,7 @@
 #include "daScript/simulate/simulate_nodes.h"
 #include "daScript/simulate/runtime_string.h"
 #include "daScript/simulate/debug_print.h"
+#include "daScript/simulate/heap_sampler.h"
 #include "daScript/misc/fpe.h"
 #include "daScript/misc/debug_break.h"
 #include "daScript/ast/ast.h"
@@ -893,10 +894,25 @@ namespace das
         });
     }
 
+#if DAS_COMPACT_DEBUG_INFO
+    LineInfo & makeNodeLineInfo ( const LineInfo & at ) {
+        if ( g_nodeLineInfoTable ) return *g_nodeLineInfoTable->makeNodeLineInfo(at);
+        if ( at.empty() ) return LineInfo::g_LineInfoNULL;     // i.e. jit blocks, which are made in place
+        static std::mutex orphanMutex;
+        static DebugInfoAllocator orphanTable;
+        std::lock_guard<std::mutex> guard(orphanMutex);
+        return *orphanTable.makeNodeLineInfo(at);
+    }
+#endif
+
     Context::Context(uint32_t stackSize, bool ph) : stack(stackSize) {
         code = make_shared<NodeAllocator>();
         constStringHeap = make_shared<ConstStringAllocator>();
         debugInfo = make_shared<DebugInfoAllocator>();
+        hotPatches = make_shared<vector<HotPatchGeneration>>();
+#if DAS_COMPACT_DEBUG_INFO
+        code->lineInfoTable = debugInfo.get();
+#endif
         ownStack = (stackSize != 0);
         persistent = ph;
     }
@@ -965,6 +981,12 @@ namespace das
                 << ", depth = " << debugInfo->depth() << "\n";
             bytesTotal += debugInfo->totalAlignedMemoryAllocated();
             bytesUsed += debugInfo->bytesAllocated();
+#if DAS_COMPACT_DEBUG_INFO
+            tw << "\tnode line info: " << debugInfo->lineInfo.bytesAllocated() << " of " << debugInfo->lineInfo.totalAlignedMemoryAllocated()
+                << ", depth = " << debugInfo->lineInfo.depth() << "\n";
+            bytesTotal += debugInfo->lineInfo.totalAlignedMemoryAllocated();
+            bytesUsed += debugInfo->lineInfo.bytesAllocated();
+#endif
         }
     // stack
         if ( stack.bottom() ) {
@@ -1027,6 +1049,7 @@ namespace das
         // functions
         functions = ctx.functions;
         totalFunctions = ctx.totalFunctions;
+        hotPatches = ctx.hotPatches;    // shared function table may point to the hot patched code, generations are shared too
 
         // mangled name table
         tabMnLookup = ctx.tabMnLookup;
@@ -1055,7 +1078,7 @@ namespace das
     }
 
 
-    Context::Context(const Context & ctx, uint32_t category_): stack(ctx.stack.size()) {
+    Context::Context(const Context & ctx, uint32_t category_, bool runInit): stack(ctx.stack.size()) {
         persistent = ctx.persistent;
         code = ctx.code;
         constStringHeap = ctx.constStringHeap;
@@ -1074,6 +1097,9 @@ namespace das
         }
         // heap
         heap->setInitialSize(ctx.heap->getInitialSize());
+        if ( auto nursery = ctx.heap->asNursery() ) {
+            heap = make_smart<NurseryHeapAllocator>(heap, nursery->getRegionSize());
+        }
         heap->setLimit(ctx.heap->getLimit());
         stringHeap->setInitialSize(ctx.stringHeap->getInitialSize());
         stringHeap->setIntern(ctx.stringHeap->isIntern());
@@ -1094,6 +1120,7 @@ namespace das
         // functoins
         functions = ctx.functions;
         totalFunctions = ctx.totalFunctions;
+        hotPatches = ctx.hotPatches;    // shared function table may point to the hot patched code, generations are shared too
         initFunctions = ctx.initFunctions;
         totalInitFunctions = ctx.totalInitFunctions;
         // mangled name table
@@ -1104,11 +1131,16 @@ namespace das
         skipLockChecks = ctx.skipLockChecks;
         // threadlock_context
         if ( ctx.contextMutex ) contextMutex = new recursive_mutex;
+        // tenant, so that init script is accounted for
+        if ( ctx.tenant ) setTenant(ctx.tenant);
         // register
         announceCreation();
         // now, make it good to go
         restart();
-        if ( stack.size() > globalInitStackSize ) {
+        if ( !runInit ) {
+            // globals are going to be copied over, see forkFrom
+            if ( globals ) memset(globals, 0, globalsSize);
+        } else if ( stack.size() > globalInitStackSize ) {
             runInitScript();
         } else {
             auto ssz = max ( int(stack.size()), 16384 ) + globalInitStackSize;
@@ -1138,6 +1170,11 @@ namespace das
         });
         // shutdown
         runShutdownScript();
+        setTenant(nullptr);
+#if DAS_DEBUGGER
+        // release single step traps
+        if ( singleStepMode ) setSingleStep(false);
+#endif
         // and free memory
         if ( globals && globalsOwner ) {
             das_aligned_free16(globals);
@@ -1175,6 +1212,9 @@ namespace das
             // printf("[REL] %i not adjusting\n", code->totalNodesAllocated);
         }
         rel.newCode->prefixWithHeader = pwh;
+#if DAS_COMPACT_DEBUG_INFO
+        rel.newCode->lineInfoTable = code->lineInfoTable;
+#endif
         rel.newCode->setInitialSize(codeSize);
         SimFunction * oldFunctions = functions;
         if ( totalFunctions ) {
@@ -1228,6 +1268,132 @@ namespace das
         code = rel.newCode;
     }
 
+    typedef das_safe_set<pair<const StructInfo *,const StructInfo *>> LayoutPairs;
+
+    static bool isSameName ( const char * a, const char * b ) {
+        return (a ? a : "") == string(b ? b : "");
+    }
+
+    static bool isSameLayout ( const TypeInfo * a, const TypeInfo * b, LayoutPairs & visited );
+
+    static bool isSameLayout ( const StructInfo * a, const StructInfo * b, LayoutPairs & visited ) {
+        if ( a==b ) return true;
+        if ( !a || !b ) return false;
+        if ( !visited.insert(make_pair(a,b)).second ) return true;
+        if ( !isSameName(a->name,b->name) || a->size!=b->size || a->count!=b->count || a->flags!=b->flags ) return false;
+        for ( uint32_t i=0, is=a->count; i!=is; ++i ) {
+            auto fa = a->fields[i];
+            auto fb = b->fields[i];
+            if ( !isSameName(fa->name,fb->name) || fa->offset!=fb->offset || !isSameLayout(fa,fb,visited) ) return false;
+        }
+        return true;
+    }
+
+    static bool isSameLayout ( const EnumInfo * a, const EnumInfo * b ) {
+        if ( a==b ) return true;
+        if ( !a || !b ) return false;
+        if ( !isSameName(a->name,b->name) || a->count!=b->count ) return false;
+        for ( uint32_t i=0, is=a->count; i!=is; ++i ) {
+            if ( a->fields[i]->value!=b->fields[i]->value || !isSameName(a->fields[i]->name,b->fields[i]->name) ) return false;
+        }
+        return true;
+    }
+
+    // data of type 'a' can be read as data of type 'b'
+    static bool isSameLayout ( const TypeInfo * a, const TypeInfo * b, LayoutPairs & visited ) {
+        if ( a==b ) return true;
+        if ( !a || !b ) return false;
+        if ( a->type!=b->type || a->flags!=b->flags || a->size!=b->size || a->dimSize!=b->dimSize || a->argCount!=b->argCount ) return false;
+        for ( uint32_t i=0, is=a->dimSize; i!=is; ++i ) {
+            if ( a->dim[i]!=b->dim[i] ) return false;
+        }
+        switch ( a->type ) {
+        case Type::tStructure:
+            if ( !isSameLayout(a->getStructType(),b->getStructType(),visited) ) return false;
+            break;
+        case Type::tEnumeration:
+        case Type::tEnumeration8:
+        case Type::tEnumeration16:
+            if ( !isSameLayout(a->getEnumType(),b->getEnumType()) ) return false;
+            break;
+        case Type::tHandle:
+            if ( a->getAnnotation()!=b->getAnnotation() ) return false;
+            break;
+        default:
+            break;
+        }
+        if ( !isSameLayout(a->firstType,b->firstType,visited) || !isSameLayout(a->secondType,b->secondType,visited) ) return false;
+        for ( uint32_t i=0, is=a->argCount; i!=is; ++i ) {
+            if ( a->argTypes && !isSameLayout(a->argTypes[i],b->argTypes[i],visited) ) return false;
+            if ( a->argNames && (!b->argNames || !isSameName(a->argNames[i],b->argNames[i])) ) return false;
+        }
+        return true;
+    }
+
+    // lambda and generator functions read the captured data of the lambdas, which already exist
+    static bool isLambdaFunction ( const SimFunction * fn ) {
+        auto info = fn->debugInfo;
+        if ( !info || !info->count ) return false;
+        const TypeInfo * self = info->fields[0];
+        if ( self->type==Type::tPointer && self->firstType ) self = self->firstType;
+        if ( self->type!=Type::tStructure ) return false;
+        auto st = self->getStructType();
+        return st && (st->flags & StructInfo::flag_lambda);
+    }
+
+    // Replaces code of the functions, which changed in the 'fresh' context, while keeping globals and heap of this one.
+    // Returns number of patched functions, or -1 if data layout is different and the context needs to be fully reloaded.
+    int32_t Context::hotPatch ( const smart_ptr<Context> & fresh ) {
+        if ( !fresh || fresh.get()==this || insideContext ) return -1;
+        if ( totalVariables!=fresh->totalVariables || globalsSize!=fresh->globalsSize || sharedSize!=fresh->sharedSize ) return -1;
+        LayoutPairs visited;
+        for ( int i=0, is=totalVariables; i!=is; ++i ) {
+            const auto & va = globalVariables[i];
+            const auto & vb = fresh->globalVariables[i];
+            if ( va.mangledNameHash!=vb.mangledNameHash || va.offset!=vb.offset || va.size!=vb.size || va.flags!=vb.flags ) return -1;
+            if ( !isSameLayout(va.debugInfo,vb.debugInfo,visited) ) return -1;
+        }
+        vector<pair<SimFunction *,SimFunction *>> changed;
+        for ( int i=0, is=fresh->totalFunctions; i!=is; ++i ) {
+            auto & nfn = fresh->functions[i];
+            auto ofn = fnByMangledName(nfn.mangledNameHash);
+            if ( !ofn ) continue;   // new function, only new code can call it
+            if ( getSemanticHash(ofn->code,this)==getSemanticHash(nfn.code,fresh.get()) ) continue;
+            if ( isLambdaFunction(ofn) ) return -1;
+            changed.emplace_back(ofn,&nfn);
+        }
+        if ( changed.empty() ) return 0;
+        for ( auto & ch : changed ) {
+            auto ofn = ch.first;
+            auto nfn = ch.second;
+            ofn->code = nfn->code;
+            ofn->debugInfo = nfn->debugInfo;
+            ofn->stackSize = nfn->stackSize;
+            ofn->aotFunction = nfn->aotFunction;
+            ofn->flags = nfn->flags;
+        }
+        // running clones may be looking up the shared table, so new functions go into a copy of it
+        shared_ptr<das_hash_map<uint64_t,SimFunction *>> lookup;
+        for ( int i=0, is=fresh->totalFunctions; i!=is; ++i ) {
+            auto & nfn = fresh->functions[i];
+            if ( !fnByMangledName(nfn.mangledNameHash) ) {
+                if ( !lookup ) lookup = make_shared<das_hash_map<uint64_t,SimFunction *>>(*tabMnLookup);
+                (*lookup)[nfn.mangledNameHash] = &nfn;
+            }
+        }
+        if ( lookup ) tabMnLookup = lookup;
+        // new code calls functions through the function table of its own context, so every table follows ours
+        hotPatches->push_back({fresh->code, fresh->debugInfo, fresh->constStringHeap, fresh->functions, fresh->totalFunctions});
+        for ( auto & gen : *hotPatches ) {
+            for ( int i=0, is=gen.totalFunctions; i!=is; ++i ) {
+                auto & gfn = gen.functions[i];
+                auto ofn = fnByMangledName(gfn.mangledNameHash);
+                if ( ofn && ofn!=&gfn ) gfn = *ofn;
+            }
+        }
+        return int32_t(changed.size());
+    }
+
     void Context::announceCreation() {
         for_each_debug_agent([&](const DebugAgentPtr & pAgent){
             pAgent->onCreateContext(this);
@@ -1402,7 +1568,7 @@ namespace das
             ssw << fileName << ", AOT";
         }
         virtual void onCallAt ( Prologue *, FuncInfo * info, LineInfo * at ) override {
-            ssw << info->name << " from " << at->describe();
+            ssw << info->name << " from " << at->describe() << at->describeInlined();
         }
         virtual void onCall ( Prologue *, FuncInfo * info ) override {
             ssw << info->name;
@@ -1467,7 +1633,7 @@ namespace das
     #if DAS_ENABLE_STACK_WALK
         ssw << "\n";
         if ( at ) {
-            ssw << "from " << at->describe() << "\n";
+            ssw << "from " << at->describe() << at->describeInlined() << "\n";
         }
         char * sp = stack.ap();
         ssw << "CALL STACK (sp=" << (stack.top() - stack.ap())
@@ -1694,9 +1860,9 @@ namespace das
     }
 
     void Context::triggerHwBreakpoint ( void * addr, int index ) {
-        singleStepMode = true;
         hwBpAddress = addr;
         hwBpIndex = index;
+        setSingleStep(true);
     }
 
     void Context::breakPoint(const LineInfo & at, const char * reason, const char * text) {
@@ -1743,7 +1909,40 @@ namespace das
         throw_fatal_error(buffer, at);
     }
 
+    void Context::setTenant ( const smart_ptr<ContextTenant> & t ) {
+        if ( tenant ) {
+            heap->setTenant(nullptr);
+            stringHeap->setTenant(nullptr);
+            tenant->removeContext(this);
+        }
+        tenant = t;
+        if ( tenant ) {
+            heap->setTenant(tenant.get());
+            stringHeap->setTenant(tenant.get());
+            tenant->addContext(this);
+        }
+    }
+
+    char * Context::reclaimAndAllocate ( char * ptr, uint32_t oldSize, uint32_t size ) {
+        auto over = tenant->overLimit(int64_t(size)-int64_t(oldSize));
+        if ( !over ) return nullptr;    // context's own limit, not the tenant's
+        if ( !over->collectIdle(this) ) return nullptr;
+        return ptr ? heap->impl_reallocate(ptr, oldSize, size) : heap->impl_allocate(size);
+    }
+
+    void Context::throw_budget_exceeded ( const LineInfo * at ) {
+        stopFlags &= ~EvalFlags::stopForBudget;
+        tenant->budgetStops ++;
+        throw_error_at(at, "tenant '%s' is out of its time budget", tenant->name.c_str());
+    }
+
     void Context::throw_out_of_memory ( bool isStringHeap, uint32_t size, const LineInfo * at ) {
+        if ( tenant ) {
+            if ( auto over = tenant->overLimit(size) ) {
+                throw_error_at(at, "out of %s memory, requested %u bytes, tenant '%s' limit is %llu bytes",
+                    isStringHeap ? "string heap" : "heap", size, over->name.c_str(), (unsigned long long) over->limit);
+            }
+        }
         if ( isStringHeap ) {
             throw_error_at(at, "out of string heap memory, requested %u bytes, limit is %llu bytes", size, (unsigned long long) stringHeap->getLimit());
         } else {
@@ -1917,35 +2116,69 @@ namespace das
     }
 
     void Context::onAllocateString ( void * ptr, uint64_t size, const LineInfo & at ) {
+        if ( heapSampler ) heapSampler->onAllocate(this, ptr, size, at);
         if ( g_envTotal > 0 && daScriptEnvironment::bound && daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent ) {
             daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent->onAllocateString(this, ptr, size, at);
         }
     }
 
     void Context::onFreeString ( void * ptr, const LineInfo & at ) {
+        if ( heapSampler ) heapSampler->onFree(ptr);
         if ( g_envTotal > 0 && daScriptEnvironment::bound && daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent ) {
             daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent->onFreeString(this, ptr, at);
         }
     }
 
     void Context::onAllocate ( void * ptr, uint64_t size, const LineInfo & at ) {
+        if ( heapSampler ) heapSampler->onAllocate(this, ptr, size, at);
         if ( g_envTotal > 0 && daScriptEnvironment::bound && daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent ) {
             daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent->onAllocate(this, ptr, size, at);
         }
     }
 
     void Context::onReallocate ( void * ptr, uint64_t size, void * newPtr, uint64_t newSize, const LineInfo & at ) {
+        if ( heapSampler ) heapSampler->onReallocate(this, ptr, size, newPtr, newSize, at);
         if ( g_envTotal > 0 && daScriptEnvironment::bound && daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent ) {
             daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent->onReallocate(this, ptr, size, newPtr, newSize, at);
         }
     }
 
     void Context::onFree ( void * ptr, const LineInfo & at ) {
+        if ( heapSampler ) heapSampler->onFree(ptr);
         if ( g_envTotal > 0 && daScriptEnvironment::bound && daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent ) {
             daScriptEnvironment::bound->g_threadLocalDebugAgent.debugAgent->onFree(this, ptr, at);
         }
     }
 
+    void Context::enableHeapSampler ( uint64_t sampleRate, int32_t maxDepth ) {
+        bool ownsInstrumentation = heapSampler ? heapSampler->ownsInstrumentation : !instrumentAllocations;
+        heapSampler = make_unique<HeapSampler>(sampleRate, maxDepth);
+        heapSampler->ownsInstrumentation = ownsInstrumentation;
+        instrumentAllocations = true;
+    }
+
+    void Context::disableHeapSampler () {
+        if ( !heapSampler ) return;
+        if ( heapSampler->ownsInstrumentation ) instrumentAllocations = false;
+        heapSampler.reset();
+    }
+
+    void Context::pruneHeapSampler ( bool all ) {
+        if ( !heapSampler ) return;
+        if ( all ) {
+            heapSampler->reset();
+            return;
+        }
+        heapSampler->prune([&]( void * p, uint64_t size ) -> bool {
+            auto ptr = (char *) p;
+            uint32_t hsize = (uint32_t(size) + 15) & ~15;
+            if ( hsize && heap->isOwnPtr(ptr, hsize) ) return heap->isValidPtr(ptr, hsize);
+            uint32_t ssize = (uint32_t(size) + 1 + 15) & ~15;     // string, and its terminator
+            if ( stringHeap->isOwnPtr(ptr, ssize) ) return stringHeap->isValidPtr(ptr, ssize);
+            return false;
+        });
+    }
+
     const LineInfo * SimFunction::getLineInfo() const { return &code->debugInfo; }
 }
 
@@ -8,27 +8,28 @@
 #include "daScript/simulate/simulate_fusion.h"
 #include "daScript/simulate/sim_policy.h"
 #include "daScript/simulate/simulate_visit_op.h"
+#include "daScript/simulate/simulate_fusion_op2_patterns.h"
 
 namespace das {
 
-    bool FusionPoint::is ( const SimNodeInfoLookup & info, SimNode * node, const char * name ) {
+    bool FusionPoint::is ( const SimNodeInfoLookup & info, SimNode * node, uint64_t kind ) {
         auto it = info.find(node);
         if ( it==info.end() ) return false;
-        return it->second.name == name;
+        return it->second.kind == kind;
     }
 
-    bool FusionPoint::is2 ( const SimNodeInfoLookup & info, SimNode * lnode, SimNode * rnode, const char * lname, const char * rname ) {
+    bool FusionPoint::is2 ( const SimNodeInfoLookup & info, SimNode * lnode, SimNode * rnode, uint64_t lkind, uint64_t rkind ) {
         auto itl = info.find(lnode);
-        if ( itl==info.end() || itl->second.name!=lname ) return false;
+        if ( itl==info.end() || itl->second.kind!=lkind ) return false;
         auto itr = info.find(rnode);
-        if ( itr==info.end() || itr->second.name!=rname ) return false;
+        if ( itr==info.end() || itr->second.kind!=rkind ) return false;
         return true;
     }
 
-    bool FusionPoint::is ( const SimNodeInfoLookup & info, SimNode * node, const char * name, const char * typeName ) {
+    bool FusionPoint::is ( const SimNodeInfoLookup & info, SimNode * node, uint64_t kind, uint64_t typeKind ) {
         auto it = info.find(node);
         if ( it==info.end() ) return false;
-        return (it->second.name == name) && (it->second.typeName==typeName);
+        return (it->second.kind == kind) && (it->second.typeKind==typeKind);
     }
 
     SimNode * SimNode_Op1Fusion::visit(SimVisitor & vis) {
@@ -161,13 +162,12 @@ namespace das {
             SimVisitor::preVisit(node);
             thisNode = node;
         }
-        virtual void op ( const char * name, uint32_t typeSize, const string & typeName ) override {
+        virtual void op ( const char * name, uint32_t, const string & typeName ) override {
             SimNodeInfo ni;
-            ni.name = name;
-            ni.typeName = typeName;
-            ni.typeSize = typeSize;
+            ni.kind = fusionKind(name);
+            ni.typeKind = fusionKind(typeName.c_str());
+            ni.fusedKind = fuseKind(name, typeName.c_str());
             info[thisNode] = ni;
-
         }
         das_hash_map<SimNode *,SimNodeInfo>  info;
         SimNode * thisNode = nullptr;
@@ -183,7 +183,7 @@ namespace das {
         }
         virtual SimNode * visit ( SimNode * node ) override {
             auto & ni = info[node];
-            auto it = g_fusionEngine->find(fuseName(ni.name, ni.typeName));
+            auto it = g_fusionEngine->find(ni.fusedKind);
             if ( it != g_fusionEngine->end() ) {
                 auto & nv = it->second;
                 for ( const auto & fe : nv ) {
@@ -231,7 +231,193 @@ namespace das {
     }
 
     void registerFusion ( const char * OpName, const char * CTypeName, FusionPoint * node ) {
-        (*g_fusionEngine)[fuseName(OpName,CTypeName)].emplace_back(node);
+        (*g_fusionEngine)[fuseKind(OpName,CTypeName)].emplace_back(node);
     }
+
+#if DAS_FUSION_PROFILE
+
+    DAS_THREAD_LOCAL das_hash_map<SimNode *,uint64_t> g_fusionProfile;
+
+    void resetFusionProfile() {
+        g_fusionProfile.clear();
+    }
+
+#endif
+
+#if DAS_FUSION
+
+    // for each node which is left after fusion, collects what its children are and how often it ran
+    // without DAS_FUSION_PROFILE every node counts once, i.e. the profile is static
+    struct SimFusionProfileCollector : SimVisitor {
+        struct Frame {
+            SimNode *       node = nullptr;
+            string          name;
+            string          typeName;
+            vector<string>  children;
+            vector<string>  childTypes;
+        };
+        virtual void preVisit ( SimNode * node ) override {
+            SimVisitor::preVisit(node);
+            stack.emplace_back();
+            stack.back().node = node;
+        }
+        virtual void op ( const char * name, uint32_t, const string & typeName ) override {
+            if ( !stack.empty() && stack.back().name.empty() ) {
+                stack.back().name = name;
+                stack.back().typeName = typeName;
+            }
+        }
+        virtual SimNode * visit ( SimNode * node ) override {
+            if ( stack.empty() || stack.back().node!=node ) return node;
+            Frame frame = das::move(stack.back());
+            stack.pop_back();
+#if DAS_FUSION_PROFILE
+            auto it = g_fusionProfile.find(node);
+            uint64_t count = it!=g_fusionProfile.end() ? it->second : 0;
+#else
+            uint64_t count = 1;
+#endif
+            if ( count ) {
+                auto fname = fuseName(frame.name, frame.typeName);
+                if ( !stack.empty() ) {
+                    pairs[fuseName(stack.back().name, stack.back().typeName) + " ( " + fname + " )"] += count;
+                }
+                if ( frame.children.size()>=2 ) {
+                    triples[fname + " ( " + frame.children[0] + ", " + frame.children[1] + " )"] += count;
+                    operands[fname].emplace_back(frame.children[0], frame.children[1]);
+                    operandCounts[fname].push_back(count);
+                }
+            }
+            if ( !stack.empty() ) {
+                stack.back().children.push_back(frame.name);
+                stack.back().childTypes.push_back(frame.typeName);
+            }
+            return node;
+        }
+        vector<Frame>                                       stack;
+        das_map<string,uint64_t>                            pairs;
+        das_map<string,uint64_t>                            triples;
+        das_map<string,vector<pair<string,string>>>         operands;
+        das_map<string,vector<uint64_t>>                    operandCounts;
+    };
+
+    static void reportTop ( TextWriter & tout, const das_map<string,uint64_t> & counts, int topN ) {
+        vector<pair<string,uint64_t>> sorted(counts.begin(), counts.end());
+        stable_sort(sorted.begin(), sorted.end(), [](auto & a, auto & b){ return a.second > b.second; });
+        for ( int i=0, is=min(topN,int(sorted.size())); i!=is; ++i ) {
+            tout << "\t" << sorted[i].second << "\t" << sorted[i].first << "\n";
+        }
+    }
+
+    void collectFusionProfile ( Context & context, TextWriter & tout, int topN ) {
+        SimFusionProfileCollector collector;
+        context.runVisitor(&collector);
+        tout << "FUSION PROFILE, parent ( child ):\n";
+        reportTop(tout, collector.pairs, topN);
+        tout << "FUSION PROFILE, parent ( left, right ):\n";
+        reportTop(tout, collector.triples, topN);
+    }
+
+    // combinations which IMPLEMENT_ANY_OP2 and IMPLEMENT_ANY_SETOP already have with DAS_FUSION>=2,
+    // and the SimSource::compute* each source node maps to, both taken from simulate_fusion_op2_patterns.h
+    struct Op2Patterns {
+        das_set<string>             op2, setop;
+        das_map<string,string>      valueSource;    // op2 operands, setop right side
+        das_map<string,string>      refSource;      // setop left side
+    };
+
+#define FUSION_OP2_PATTERN_ADD(INLINE,OPNAME,TYPE,CTYPE,LNODENAME,RNODENAME,COMPUTEL,COMPUTER) \
+    pat.op2.insert(#COMPUTEL "," #COMPUTER); \
+    pat.valueSource[LNODENAME] = #COMPUTEL; \
+    pat.valueSource[RNODENAME] = #COMPUTER;
+
+#define FUSION_OP2_SET_PATTERN_ADD(INLINE,OPNAME,TYPE,CTYPE,LNODENAME,RNODENAME,COMPUTEL,COMPUTER) \
+    pat.setop.insert(#COMPUTEL "," #COMPUTER); \
+    pat.refSource[LNODENAME] = #COMPUTEL;
+
+    static const Op2Patterns & op2Patterns() {
+        static Op2Patterns patterns = [](){
+            Op2Patterns pat;
+            FUSION_OP2_PATTERNS(FUSION_OP2_PATTERN_ADD,,,,)
+            FUSION_OP2_SET_PATTERNS(FUSION_OP2_SET_PATTERN_ADD,,,,)
+            return pat;
+        }();
+        return patterns;
+    }
+
+#undef FUSION_OP2_PATTERN_ADD
+#undef FUSION_OP2_SET_PATTERN_ADD
+
+    static const char * op2Source ( const das_map<string,string> & sources, const string & name ) {
+        auto it = sources.find(name);
+        return it!=sources.end() ? it->second.c_str() : nullptr;
+    }
+
+    void generateFusionPatterns ( Context & context, TextWriter & tout, int topN ) {
+        createFusionEngine();
+        SimFusionProfileCollector collector;
+        context.runVisitor(&collector);
+        // operand combinations of registered op2 fusion points, which did not fuse
+        struct Pattern {
+            string      lname, rname;
+            string      lcompute, rcompute;
+            uint64_t    count = 0;
+        };
+        das_map<string,Pattern> op2, setop;
+        for ( auto & it : collector.operands ) {
+            auto & fname = it.first;
+            auto lt = fname.find('<');
+            auto opName = fname.substr(0, lt);
+            auto typeName = lt!=string::npos ? fname.substr(lt+1, fname.size()-lt-2) : string();
+            if ( g_fusionEngine->find(fuseKind(opName.c_str(),typeName.c_str()))==g_fusionEngine->end() ) continue;
+            bool setOp = opName.compare(0, 3, "Set")==0;
+            auto & counts = collector.operandCounts[fname];
+            for ( size_t i=0, is=it.second.size(); i!=is; ++i ) {
+                auto & lr = it.second[i];
+                auto & patterns = op2Patterns();
+                auto lc = op2Source(setOp ? patterns.refSource : patterns.valueSource, lr.first);
+                auto rc = op2Source(patterns.valueSource, lr.second);
+                if ( !lc || !rc || (setOp ? patterns.setop : patterns.op2).count(string(lc) + "," + rc) ) continue;
+                auto & pat = (setOp ? setop : op2)[string(lc) + "_" + rc];
+                pat.lname = lr.first; pat.rname = lr.second;
+                pat.lcompute = lc; pat.rcompute = rc;
+                pat.count += counts[i];
+            }
+        }
+        auto topPatterns = [&]( das_map<string,Pattern> & patterns ) {
+            vector<Pattern> sorted;
+            for ( auto & it : patterns ) sorted.push_back(it.second);
+            stable_sort(sorted.begin(), sorted.end(), [](auto & a, auto & b){ return a.count > b.count; });
+            if ( int(sorted.size()) > topN ) sorted.resize(topN);
+            return sorted;
+        };
+        auto op2Top = topPatterns(op2);
+        auto setTop = topPatterns(setop);
+        tout << "// generated by generateFusionPatterns from a workload profile, DAS_FUSION_PROFILE=" << DAS_FUSION_PROFILE << "\n";
+        tout << "// included by simulate_fusion_op2.h, expanded by simulate_fusion_op2_impl.h and simulate_fusion_op2_set_impl.h with DAS_FUSION>=2\n\n";
+        tout << "#pragma once\n\n";
+        for ( auto & pat : op2Top ) tout << "// " << pat.count << " OP2 ( " << pat.lname << ", " << pat.rname << " )\n";
+        tout << "#define IMPLEMENT_OP2_GENERATED_NODES(INLINE,OPNAME,TYPE,CTYPE)";
+        for ( auto & pat : op2Top ) {
+            tout << " \\\n    IMPLEMENT_OP2_NODE(INLINE,OPNAME,TYPE,CTYPE," << pat.lcompute << "," << pat.rcompute << ");";
+        }
+        tout << "\n\n#define MATCH_OP2_GENERATED(OPNAME)";
+        for ( auto & pat : op2Top ) {
+            tout << " \\\n    MATCH_OP2(OPNAME,\"" << pat.lname << "\",\"" << pat.rname << "\"," << pat.lcompute << "," << pat.rcompute << ")";
+        }
+        tout << "\n\n";
+        for ( auto & pat : setTop ) tout << "// " << pat.count << " SETOP ( " << pat.lname << ", " << pat.rname << " )\n";
+        tout << "#define IMPLEMENT_OP2_SET_GENERATED_NODES(INLINE,OPNAME,TYPE,CTYPE)";
+        for ( auto & pat : setTop ) {
+            tout << " \\\n    IMPLEMENT_OP2_SET_NODE(INLINE,OPNAME,TYPE,CTYPE," << pat.lcompute << "," << pat.rcompute << ");";
+        }
+        tout << "\n\n#define MATCH_OP2_SET_GENERATED(OPNAME)";
+        for ( auto & pat : setTop ) {
+            tout << " \\\n    MATCH_OP2_SET(OPNAME,\"" << pat.lname << "\",\"" << pat.rname << "\"," << pat.lcompute << "," << pat.rcompute << ")";
+        }
+        tout << "\n";
+    }
+
+#endif
 }
 
@@ -29,7 +29,7 @@ namespace das {
         };
         virtual SimNode * match(const SimNodeInfoLookup & info, SimNode *, SimNode * node_l, SimNode *, Context * context) override {
             if (false) {}
-            else if ( is(info, node_l, "GetLocal" )) { anyRight = true; return context->code->makeNode<SimNode_CopyReferenceLocAny>();  }
+            else if ( is(info, node_l, DAS_FUSION_KIND("GetLocal"))) { anyRight = true; return context->code->makeNode<SimNode_CopyReferenceLocAny>();  }
             return nullptr;
         }
         virtual void set(SimNode_Op2Fusion * result, SimNode * node) override {
@@ -74,19 +74,19 @@ namespace das {
     }
 
 #define MATCH_OP2_COPYREF_LEFT_ANY(NODENAME,COMPUTEL) \
-    else if (is(info, node_l, NODENAME) ) { \
+    else if (is(info,node_l,DAS_FUSION_KIND(NODENAME)) ) { \
         anyRight = true; \
         MATCH_OP2_COPYREF_NODE(COMPUTEL,AnyPtr); \
     }
 
 #define MATCH_OP2_COPYREF_RIGHT_ANY(NODENAME,COMPUTER) \
-    else if (is(info, node_r, NODENAME) ) { \
+    else if (is(info,node_r,DAS_FUSION_KIND(NODENAME)) ) { \
         anyLeft = true; \
         MATCH_OP2_COPYREF_NODE(AnyPtr,COMPUTER); \
     }
 
 #define MATCH_OP2_COPYREF(LNODENAME,RNODENAME,COMPUTEL,COMPUTER) \
-    else if ( is2(info,node_l,node_r,LNODENAME,RNODENAME) ) { \
+    else if ( is2(info,node_l,node_r,DAS_FUSION_KIND(LNODENAME),DAS_FUSION_KIND(RNODENAME)) ) { \
         MATCH_OP2_COPYREF_NODE(COMPUTEL,COMPUTER); \
     }
 
@@ -158,8 +158,8 @@ namespace das {
     };
 
     void createFusionEngine_misc_copy_reference() {
-        (*g_fusionEngine)["CopyReference"].emplace_back(new FusionPoint_MiscCopyReference());
-        (*g_fusionEngine)["CopyRefValue"].emplace_back(new FusionPoint_MiscCopyRefValue());
+        (*g_fusionEngine)[fusionKind("CopyReference")].emplace_back(new FusionPoint_MiscCopyReference());
+        (*g_fusionEngine)[fusionKind("CopyRefValue")].emplace_back(new FusionPoint_MiscCopyRefValue());
     }
 }
 
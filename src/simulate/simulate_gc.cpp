@@ -4,6 +4,7 @@
 #include "daScript/simulate/simulate.h"
 #include "daScript/simulate/data_walker.h"
 #include "daScript/simulate/debug_print.h"
+#include "daScript/simulate/heap_sampler.h"
 
 namespace das
 {
@@ -12,6 +13,9 @@ namespace das
 
     char * presentStr ( char * buf, char * ch, int size );
 
+    extern "C" int64_t ref_time_ticks ();
+    extern "C" int get_time_usec (int64_t reft);
+
     struct PtrRange {
         char * from = nullptr;
         char * to = nullptr;
@@ -977,6 +981,8 @@ namespace das
     };
 
     void Context::collectHeap ( LineInfo * at, bool sheap, bool validate ) {
+        // survivors of the nursery go to the regular heap first, so that it can be swept as usual
+        collectNursery(at);
         GcGuard guard(this);
         // clean up, so that all small allocations are marked as 'free'
         stringDisposeQue = nullptr;
@@ -1014,6 +1020,7 @@ namespace das
             walker.walk(globals + pv.offset, pv.debugInfo);
         }
         // mark stack
+        auto nursery = heap->asNursery();
         char * sp = stack.ap();
         const LineInfo * lineAt = at;
         while (  sp < stack.top() ) {
@@ -1044,6 +1051,8 @@ namespace das
                         char * addr = nullptr;
                         if ( lv->cmres ) {
                             addr = (char *)pp->cmres;
+                            // result is written in place, the retired region it points into is still in use
+                            if ( nursery && nursery->isRetired(addr) ) nursery->mark(addr, 0);
                         } else {
                             addr = SP + lv->stackTop;
                         }
@@ -1061,6 +1070,10 @@ namespace das
         if ( sheap ) stringHeap->sweep();
         // report errors
         heap->sweep();
+        // tenant gets back what was swept
+        heap->syncTenant();
+        if ( sheap ) stringHeap->syncTenant();
+        pruneHeapSampler(false);
         if ( !walker.failed.empty() ) {
             reportAnyHeap(at, sheap, true, true, true);
             TextWriter tw;
@@ -1072,4 +1085,550 @@ namespace das
             throw_error_at(at, "%s", etext);
         }
     }
+
+    struct LoopPointHash {
+        __forceinline size_t operator () ( const loop_point & lp ) const {
+            return size_t(intptr_t(lp.first)>>4) ^ size_t(lp.second);
+        }
+    };
+
+    // traces everything reachable, and records every location which points into the nursery
+    //  nothing is modified during the trace, so it can give up (pin) at any point
+    //  young data which is only visible through iterators, handles, or void pointers pins the nursery
+    struct GcTraceNursery final : BaseGcDataWalker {
+        NurseryHeapAllocator *  nursery = nullptr;
+        vector<uint8_t>         live;
+        vector<char **>         fixups;
+        das_hash_set<loop_point,LoopPointHash> seen;
+        das_hash_map<StructInfo *,bool>        relocatableStructs;
+        int32_t                 opaque = 0;
+        bool                    pinned = false;
+        void prepare() {
+            gcFlags = TypeInfo::flag_heapGC;
+            gcStructFlags = StructInfo::flag_heapGC;
+            live.resize(nursery->youngAllocations());
+        }
+        // native types which can't be placed in containers can't be moved with memcpy either
+        bool relocatableStruct ( StructInfo * si ) {
+            auto it = relocatableStructs.find(si);
+            if ( it!=relocatableStructs.end() ) return it->second;
+            relocatableStructs[si] = true;
+            bool res = true;
+            for ( uint32_t i=0, is=si->count; i!=is && res; ++i ) {
+                res = relocatable(si->fields[i]);
+            }
+            relocatableStructs[si] = res;
+            return res;
+        }
+        bool relocatable ( TypeInfo * ti ) {
+            if ( ti->flags & TypeInfo::flag_ref ) return true;
+            switch ( ti->type ) {
+                case Type::tHandle:     return ti->getAnnotation()->canBePlacedInContainer();
+                case Type::tStructure:  return relocatableStruct(ti->structType);
+                case Type::tTuple:
+                case Type::tVariant:
+                    for ( uint32_t i=0, is=ti->argCount; i!=is; ++i ) {
+                        if ( !relocatable(ti->argTypes[i]) ) return false;
+                    }
+                    return true;
+                default:                return true;
+            }
+        }
+        void location ( char ** loc, TypeInfo * ti = nullptr ) {
+            char * ptr = *loc;
+            auto idx = nursery->findAllocation(ptr);
+            if ( idx<0 ) return;
+            if ( ti && ti->type==Type::tStructure && (ti->structType->flags & StructInfo::flag_class) ) {
+                if ( !relocatableStruct((*(TypeInfo **)ptr)->structType) ) pinned = true;
+            } else if ( ti && !relocatable(ti) ) {
+                pinned = true;
+            }
+            if ( opaque ) {
+                pinned = true;
+            } else {
+                live[idx] = 1;
+                fixups.push_back(loc);
+            }
+        }
+        bool firstVisit ( char * ptr, TypeInfo * ti ) {
+            return seen.insert(make_pair(ptr,ti->hash)).second;
+        }
+        virtual void beforeStructure ( char * pa, StructInfo * ti ) override {
+            visited.emplace_back(make_pair(pa,ti->hash));
+        }
+        virtual void afterStructure ( char *, StructInfo * ) override {
+            visited.pop_back();
+        }
+        virtual void beforeHandle ( char * pa, TypeInfo * ti ) override {
+            visited_handles.emplace_back(make_pair(pa,ti->hash));
+        }
+        virtual void afterHandle ( char *, TypeInfo * ) override {
+            visited_handles.pop_back();
+        }
+
+        using DataWalker::walk;
+
+        virtual void walk ( char * pa, TypeInfo * info ) override {
+            if ( pinned || pa == nullptr ) {
+            } else if ( info->flags & TypeInfo::flag_ref ) {
+                TypeInfo ti = *info;
+                ti.flags &= ~TypeInfo::flag_ref;
+                location((char **)pa, &ti);
+                walk(*(char **)pa, &ti);
+            } else if ( info->dimSize ) {
+                walk_dim(pa, info);
+            } else {
+                switch ( info->type ) {
+                    case Type::tArray: {
+                            auto arr = (Array *) pa;
+                            if ( arr->data ) {
+                                location(&arr->data);
+                                if ( firstVisit(arr->data, info) ) {
+                                    walk_array(arr->data, info->firstType->size, arr->size, info->firstType);
+                                }
+                            }
+                        }
+                        break;
+                    case Type::tTable: {
+                            auto tab = (Table *) pa;
+                            if ( tab->data ) {
+                                location(&tab->data);
+                                location(&tab->keys);
+                                location((char **)&tab->hashes);
+                                if ( firstVisit(tab->data, info) ) {
+                                    walk_table(tab, info);
+                                }
+                            }
+                        }
+                        break;
+                    case Type::tPointer: {
+                            auto ptr = *(char **)pa;
+                            if ( !ptr ) break;
+                            if ( !info->firstType || info->firstType->type==Type::tVoid ) {
+                                // we don't know what is there, so it can't be moved
+                                if ( nursery->isYoung(ptr) ) pinned = true;
+                            } else if ( !(info->flags & TypeInfo::flag_isSmartPtr) ) {
+                                location((char **)pa, info->firstType);
+                                if ( firstVisit(ptr, info->firstType) ) {
+                                    walk(ptr, info->firstType);
+                                }
+                            }
+                        }
+                        break;
+                    case Type::tStructure:  walk_struct(pa, info->structType); break;
+                    case Type::tTuple:      walk_tuple(pa, info); break;
+                    case Type::tVariant:    walk_variant(pa, info); break;
+                    case Type::tLambda: {
+                            auto ll = (Lambda *) pa;
+                            if ( ll->capture ) {
+                                auto lti = ll->getTypeInfo();
+                                location(&ll->capture, lti);
+                                if ( firstVisit(ll->capture, lti) ) {
+                                    walk(ll->capture, lti);
+                                }
+                            }
+                        }
+                        break;
+                    case Type::tIterator: {
+                            auto ll = (Sequence *) pa;
+                            if ( ll->iter ) {
+                                if ( nursery->isYoung((char *)ll->iter) ) {
+                                    pinned = true;
+                                } else if ( firstVisit((char *)ll->iter, info) ) {
+                                    opaque ++;
+                                    ll->iter->walk(*this);
+                                    opaque --;
+                                }
+                            }
+                        }
+                        break;
+                    case Type::tHandle:
+                        if ( nursery->isYoung(pa) ) {
+                            // native types are not relocatable in general
+                            pinned = true;
+                        } else if ( canVisitHandle(pa, info) ) {
+                            beforeHandle(pa, info);
+                            opaque ++;
+                            info->getAnnotation()->walk(*this, pa);
+                            opaque --;
+                            afterHandle(pa, info);
+                        }
+                        break;
+                    default: break;
+                }
+            }
+        }
+    };
+
+    void Context::collectNursery ( LineInfo * at ) {
+        auto nursery = heap->asNursery();
+        if ( !nursery || !nursery->youngBytes() ) return;
+        auto t0 = ref_time_ticks();
+        GcTraceNursery walker;
+        walker.context = this;
+        walker.nursery = nursery;
+        walker.prepare();
+        // gc roots
+        foreach_gc_root([&](void * _pa, TypeInfo * ti) {
+            char * pa = (char *) _pa;
+            if ( ti ) {
+                walker.walk(pa, ti);
+            } else if ( nursery->isYoung(pa) ) {
+                walker.pinned = true;       // root is registered by its address
+            } else {
+                Lambda lmb(pa);
+                walker.walk((char *)&lmb, &lambda_type_info);
+            }
+        });
+        // globals
+        if ( sharedOwner ) {
+            for ( int i=0, is=totalVariables; i!=is; ++i ) {
+                auto & pv = globalVariables[i];
+                if ( !pv.shared ) continue;
+                walker.walk(shared + pv.offset, pv.debugInfo);
+            }
+        }
+        for ( int i=0, is=totalVariables; i!=is; ++i ) {
+            auto & pv = globalVariables[i];
+            if ( pv.shared ) continue;
+            walker.walk(globals + pv.offset, pv.debugInfo);
+        }
+        // stack, arguments are walked in place so that they can be patched
+        char * sp = stack.ap();
+        const LineInfo * lineAt = at;
+        while (  sp < stack.top() ) {
+            Prologue * pp = (Prologue *) sp;
+            Block * block = nullptr;
+            FuncInfo * info = nullptr;
+            char * SP = sp;
+            if ( pp->info ) {
+                intptr_t iblock = intptr_t(pp->block);
+                if ( iblock & 1 ) {
+                    block = (Block *) (iblock & ~1);
+                    info = block->info;
+                    SP = stack.bottom() + block->stackOffset;
+                } else {
+                    info = pp->info;
+                }
+            }
+            if ( info ) {
+                for ( uint32_t i=0, is=info->count; i!=is; ++i ) {
+                    auto parg = (char *) &pp->arguments[i];
+                    auto ainfo = info->fields[i];
+                    if ( ainfo->flags & TypeInfo::flag_refType ) {
+                        walker.location((char **)parg);
+                        walker.walk(*(char **)parg, ainfo);
+                    } else {
+                        walker.walk(parg, ainfo);
+                    }
+                }
+                if ( info->locals && lineAt ) {
+                    for ( uint32_t i=0, is=info->localCount; i!=is; ++i ) {
+                        auto lv = info->locals[i];
+                        bool inScope = lineAt->inside(lv->visibility);
+                        if ( !inScope ) continue;
+                        char * addr = nullptr;
+                        if ( lv->cmres ) {
+                            addr = (char *)pp->cmres;
+                            if ( nursery->isYoung(addr) ) walker.pinned = true;
+                        } else {
+                            addr = SP + lv->stackTop;
+                        }
+                        if ( addr ) {
+                            walker.walk(addr, lv);
+                        }
+                    }
+                }
+            }
+            lineAt = info ? pp->line : nullptr;
+            sp += info ? info->stackSize : pp->stackSize;
+        }
+        // copy survivors to the old heap, or keep the whole region if something can't be moved
+        if ( walker.pinned || !nursery->evacuate(walker.live, walker.fixups, [&]( char * from, char * to ) {
+                if ( heapSampler ) heapSampler->onMove(from, to);
+            }) ) {
+            nursery->retire();
+        }
+        heap->syncTenant();
+        pruneHeapSampler(false);
+        nursery->minorCollections ++;
+        uint64_t pause = get_time_usec(t0);
+        nursery->lastPauseUsec = pause;
+        nursery->maxPauseUsec = max(nursery->maxPauseUsec, pause);
+    }
+
+    // traces everything reachable from the globals, and records every location which holds a pointer
+    //  along with the heap and string heap allocations it points to. nothing is modified during the trace
+    struct GcTraceSnapshot final : BaseGcDataWalker {
+        struct Region {
+            char *  from = nullptr;
+            char *  to = nullptr;
+            char *  copy = nullptr;
+            bool    string = false;
+        };
+        vector<Region>          blocks;
+        vector<char **>         fixups;
+        vector<ptr_ref_count *> smartPtrs;
+        das_hash_set<loop_point,LoopPointHash> seen;
+        das_hash_map<StructInfo *,bool>        relocatableStructs;
+        int32_t                 opaque = 0;
+        string                  error;
+        void prepare() {
+            gcFlags = TypeInfo::flag_heapGC | TypeInfo::flag_stringHeapGC;
+            gcStructFlags = StructInfo::flag_heapGC | StructInfo::flag_stringHeapGC;
+        }
+        void fail ( const char * reason ) {
+            if ( error.empty() ) error = reason;
+        }
+        // native types which can't be placed in containers can't be copied with memcpy either
+        bool relocatableStruct ( StructInfo * si ) {
+            auto it = relocatableStructs.find(si);
+            if ( it!=relocatableStructs.end() ) return it->second;
+            relocatableStructs[si] = true;
+            bool res = true;
+            for ( uint32_t i=0, is=si->count; i!=is && res; ++i ) {
+                res = relocatable(si->fields[i]);
+            }
+            relocatableStructs[si] = res;
+            return res;
+        }
+        bool relocatable ( TypeInfo * ti ) {
+            if ( ti->flags & TypeInfo::flag_ref ) return true;
+            switch ( ti->type ) {
+                case Type::tHandle:     return ti->getAnnotation()->canBePlacedInContainer();
+                case Type::tStructure:  return relocatableStruct(ti->structType);
+                case Type::tTuple:
+                case Type::tVariant:
+                    for ( uint32_t i=0, is=ti->argCount; i!=is; ++i ) {
+                        if ( !relocatable(ti->argTypes[i]) ) return false;
+                    }
+                    return true;
+                default:                return true;
+            }
+        }
+        // 'loc' holds a pointer to 'size' bytes starting at 'from'
+        void location ( char ** loc, char * from, uint32_t size ) {
+            if ( opaque ) {
+                if ( context->heap->isOwnPtr(*loc, (size + 15) & ~15) ) fail("heap data is only reachable through a native type or an iterator");
+                return;
+            }
+            fixups.push_back(loc);
+            if ( size && context->heap->isOwnPtr(from, (size + 15) & ~15) ) {
+                Region r;
+                r.from = from;
+                r.to = from + size;
+                blocks.push_back(r);
+            }
+        }
+        bool firstVisit ( char * ptr, TypeInfo * ti ) {
+            return seen.insert(make_pair(ptr,ti->hash)).second;
+        }
+        virtual void beforeStructure ( char * pa, StructInfo * ti ) override {
+            visited.emplace_back(make_pair(pa,ti->hash));
+        }
+        virtual void afterStructure ( char *, StructInfo * ) override {
+            visited.pop_back();
+        }
+        virtual void beforeHandle ( char * pa, TypeInfo * ti ) override {
+            visited_handles.emplace_back(make_pair(pa,ti->hash));
+        }
+        virtual void afterHandle ( char *, TypeInfo * ) override {
+            visited_handles.pop_back();
+        }
+        virtual void String ( char * & st ) override {
+            if ( !st || opaque ) return;
+            uint32_t len = uint32_t(strlen(st)) + 1;
+            if ( !context->stringHeap->isOwnPtr(st, (len + 15) & ~15) ) return;
+            fixups.push_back(&st);
+            Region r;
+            r.from = st;
+            r.to = st + len;
+            r.string = true;
+            blocks.push_back(r);
+        }
+
+        using DataWalker::walk;
+
+        virtual void walk ( char * pa, TypeInfo * info ) override {
+            if ( !error.empty() || pa == nullptr ) {
+            } else if ( info->flags & TypeInfo::flag_ref ) {
+                TypeInfo ti = *info;
+                ti.flags &= ~TypeInfo::flag_ref;
+                location((char **)pa, *(char **)pa, ti.size);
+                walk(*(char **)pa, &ti);
+            } else if ( info->dimSize ) {
+                walk_dim(pa, info);
+            } else {
+                switch ( info->type ) {
+                    case Type::tArray: {
+                            auto arr = (Array *) pa;
+                            if ( arr->data ) {
+                                location(&arr->data, arr->data, info->firstType->size * arr->capacity);
+                                if ( firstVisit(arr->data, info) ) {
+                                    walk_array(arr->data, info->firstType->size, arr->size, info->firstType);
+                                }
+                            }
+                        }
+                        break;
+                    case Type::tTable: {
+                            auto tab = (Table *) pa;
+                            if ( tab->data ) {
+                                location(&tab->data, tab->data, (info->firstType->size + info->secondType->size + uint32_t(sizeof(TableHashKey))) * tab->capacity);
+                                location(&tab->keys, tab->keys, 0);
+                                location((char **)&tab->hashes, (char *)tab->hashes, 0);
+                                if ( firstVisit(tab->data, info) ) {
+                                    walk_table(tab, info);
+                                }
+                            }
+                        }
+                        break;
+                    case Type::tString:
+                        String(*(char **)pa);
+                        break;
+                    case Type::tPointer: {
+                            auto ptr = *(char **)pa;
+                            if ( !ptr ) break;
+                            auto pti = info->firstType;
+                            if ( info->flags & TypeInfo::flag_isSmartPtr ) {
+                                if ( !opaque ) smartPtrs.push_back((ptr_ref_count *)ptr);
+                            } else if ( !pti || pti->type==Type::tVoid ) {
+                                // we don't know what is there, so it can't be copied
+                                if ( context->heap->isOwnPtr(ptr, 16) ) fail("heap data is referenced by a void pointer");
+                            } else if ( pti->type==Type::tStructure ) {
+                                auto si = pti->structType;
+                                if ( si->flags & StructInfo::flag_class ) si = (*(TypeInfo **)ptr)->structType;
+                                if ( !relocatableStruct(si) && context->heap->isOwnPtr(ptr, (si->size + 15) & ~15) ) {
+                                    fail("structure with native fields is allocated on the heap");
+                                }
+                                if ( si->flags & StructInfo::flag_lambda ) {
+                                    location((char **)pa, ptr - 16, si->size + 16);
+                                } else {
+                                    location((char **)pa, ptr, si->size);
+                                }
+                                if ( firstVisit(ptr, pti) ) {
+                                    walk_struct(ptr, si);
+                                }
+                            } else {
+                                if ( !relocatable(pti) ) {
+                                    if ( context->heap->isOwnPtr(ptr, (pti->size + 15) & ~15) ) fail("native type is allocated on the heap");
+                                    break;
+                                }
+                                location((char **)pa, ptr, pti->size);
+                                if ( firstVisit(ptr, pti) ) {
+                                    walk(ptr, pti);
+                                }
+                            }
+                        }
+                        break;
+                    case Type::tStructure:  walk_struct(pa, info->structType); break;
+                    case Type::tTuple:      walk_tuple(pa, info); break;
+                    case Type::tVariant:    walk_variant(pa, info); break;
+                    case Type::tLambda: {
+                            auto ll = (Lambda *) pa;
+                            if ( ll->capture ) {
+                                auto lti = ll->getTypeInfo();
+                                location(&ll->capture, ll->capture - 16, lti->size + 16);
+                                if ( firstVisit(ll->capture, lti) ) {
+                                    walk(ll->capture, lti);
+                                }
+                            }
+                        }
+                        break;
+                    case Type::tIterator:
+                        if ( ((Sequence *)pa)->iter ) fail("iterators can't be copied");
+                        break;
+                    case Type::tHandle:
+                        if ( !relocatable(info) ) {
+                            fail("native type can't be copied");
+                        } else if ( canVisitHandle(pa, info) ) {
+                            beforeHandle(pa, info);
+                            opaque ++;
+                            info->getAnnotation()->walk(*this, pa);
+                            opaque --;
+                            afterHandle(pa, info);
+                        }
+                        break;
+                    default: break;
+                }
+            }
+        }
+    };
+
+    // makes this context (a clone of 'from', which skipped init) a snapshot of 'from'
+    //  globals are copied, everything reachable from them on the heap and the string heap is copied into this context,
+    //  and pointers are patched to the copies. shared globals stay shared
+    bool Context::forkFrom ( Context & from, string & error ) {
+        if ( globalsSize != from.globalsSize || code != from.code ) {
+            error = "fork must be a clone of the source context";
+            return false;
+        }
+        GcTraceSnapshot walker;
+        walker.context = &from;
+        walker.prepare();
+        for ( int i=0, is=from.totalVariables; i!=is; ++i ) {
+            auto & pv = from.globalVariables[i];
+            if ( pv.shared ) continue;
+            walker.walk(from.globals + pv.offset, pv.debugInfo);
+        }
+        if ( !walker.error.empty() ) {
+            error = walker.error;
+            return false;
+        }
+        // merge nested and overlapping allocations, i.e. pointers into arrays and the tails of tables
+        auto & blocks = walker.blocks;
+        sort(blocks.begin(), blocks.end(), [](const GcTraceSnapshot::Region & a, const GcTraceSnapshot::Region & b) {
+            return a.from < b.from || (a.from==b.from && a.to > b.to);
+        });
+        vector<GcTraceSnapshot::Region> regions;
+        regions.reserve(blocks.size() + 1);
+        for ( auto & b : blocks ) {
+            if ( !regions.empty() && b.from < regions.back().to ) {
+                regions.back().to = max(regions.back().to, b.to);
+            } else {
+                regions.push_back(b);
+            }
+        }
+        for ( auto & r : regions ) {
+            uint32_t size = uint32_t(r.to - r.from);
+            if ( r.string ) {
+                r.copy = stringHeap->impl_allocateString(this, r.from, size - 1);
+            } else {
+                r.copy = heap->impl_allocate(size);
+                if ( r.copy ) memcpy(r.copy, r.from, size);
+            }
+            if ( !r.copy ) {
+                error = "out of heap while copying " + to_string(size) + " bytes";
+                return false;
+            }
+        }
+        if ( globals ) {
+            memcpy(globals, from.globals, globalsSize);
+            GcTraceSnapshot::Region g;
+            g.from = from.globals;
+            g.to = from.globals + globalsSize;
+            g.copy = globals;
+            regions.insert(upper_bound(regions.begin(), regions.end(), g, [](const GcTraceSnapshot::Region & a, const GcTraceSnapshot::Region & b) {
+                return a.from < b.from;
+            }), g);
+        }
+        auto translate = [&]( char * ptr ) -> char * {
+            auto it = upper_bound(regions.begin(), regions.end(), ptr, [](char * p, const GcTraceSnapshot::Region & r) {
+                return p < r.from;
+            });
+            if ( it==regions.begin() ) return nullptr;
+            --it;
+            return ptr < it->to ? it->copy + (ptr - it->from) : nullptr;
+        };
+        for ( auto loc : walker.fixups ) {
+            // locations outside of the globals and the copied heap are shared by both contexts
+            auto newLoc = (char **) translate((char *)loc);
+            if ( !newLoc ) continue;
+            if ( auto newPtr = translate(*loc) ) *newLoc = newPtr;
+        }
+        // smart pointers are now held by both contexts
+        for ( auto sp : walker.smartPtrs ) {
+            sp->addRef();
+        }
+        return true;
+    }
 }
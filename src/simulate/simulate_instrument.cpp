@@ -93,6 +93,68 @@ namespace das {
         instrumentFunction(0u, false, 0ul, false);
     }
 
+    // collects every statement, which can be single stepped, and makes a trap for it
+    struct SimStepTrapVisitor : SimVisitor {
+        void addTrap ( SimNode ** slot ) {
+            auto node = *slot;
+            if ( node->rtti_node_isInstrument() ) {
+                node = ((SimNodeDebug_Instrument *) node)->subexpr;
+            }
+            auto trap = context->code->makeNode<SimNodeDebug_SingleStep>(node->debugInfo, node);
+            context->code->stepTraps.push_back({slot, node, trap});
+        }
+        virtual SimNode * visit ( SimNode * node ) override {
+            if ( node->rtti_node_isBlock() ) {
+                SimNode_Block * blk = (SimNode_Block *) node;
+                for ( uint32_t i=0, is=blk->total; i!=is; ++i ) {
+                    addTrap(&blk->list[i]);
+                }
+                for ( uint32_t i=0, is=blk->totalFinal; i!=is; ++i ) {
+                    addTrap(&blk->finalList[i]);
+                }
+            } else if ( node->rtti_node_isIf() ) {
+                SimNode_IfTheElseAny * cond = (SimNode_IfTheElseAny *) node;
+                if ( cond->if_true && !cond->if_true->rtti_node_isBlock() ) {
+                    addTrap(&cond->if_true);
+                }
+                if ( cond->if_false && !cond->if_false->rtti_node_isBlock() ) {
+                    addTrap(&cond->if_false);
+                }
+            }
+            return node;
+        }
+        Context * context = nullptr;
+    };
+
+    // code is shared between the context and its clones, so it stays patched while any of them is single stepping
+    static std::mutex g_singleStepPatchMutex;
+
+    void Context::patchSingleStep ( bool step ) {
+        std::lock_guard<std::mutex> guard(g_singleStepPatchMutex);
+        if ( step ) {
+            if ( code->stepTrapRefs++ ) return;
+            if ( code->stepTraps.empty() ) {
+                SimStepTrapVisitor collect;
+                collect.context = this;
+                runVisitor(&collect);
+            }
+        } else {
+            if ( code->stepTrapRefs==0 || --code->stepTrapRefs ) return;
+        }
+        // statement may be wrapped in the instrument node, in which case we patch under it
+        for ( auto & st : code->stepTraps ) {
+            SimNode * from = step ? st.node : st.trap;
+            SimNode * to = step ? st.trap : st.node;
+            SimNode * & slot = *st.slot;
+            if ( slot==from ) {
+                slot = to;
+            } else if ( slot->rtti_node_isInstrument() ) {
+                auto inst = (SimNodeDebug_Instrument *) slot;
+                if ( inst->subexpr==from ) inst->subexpr = to;
+            }
+        }
+    }
+
     void Context::instrumentFunction ( SimFunction * FNPTR, bool isInstrumenting, uint64_t userData, bool threadLocal ) {
         auto instFn = [&](SimFunction * fun, uint64_t fnMnh) {
             if ( !fun->code ) return;
@@ -120,6 +182,7 @@ namespace das {
         }
     }
 #else
+    void Context::patchSingleStep ( bool ) {}
     void Context::instrumentFunction ( SimFunction *, bool, uint64_t, bool ) {}
     void Context::instrumentContextNode ( const Block &, bool, Context *, LineInfo * ) {}
     void Context::clearInstruments() {}
@@ -706,6 +706,14 @@ namespace das {
         V_END();
     }
 
+    SimNode * SimNode_NewOnStack::visit ( SimVisitor & vis ) {
+        V_BEGIN();
+        V_OP(NewOnStack);
+        V_ARG(bytes);
+        V_SP(stackTop);
+        V_END();
+    }
+
     SimNode * SimNode_NewArray::visit ( SimVisitor & vis ) {
         V_BEGIN();
         V_OP(NewArray);
@@ -872,6 +880,13 @@ namespace das {
         V_END();
     }
 
+    SimNode * SimNodeDebug_SingleStep::visit ( SimVisitor & vis ) {
+        V_BEGIN();
+        V_OP(SingleStep);
+        V_SUB(subexpr);
+        V_END();
+    }
+
     SimNode * SimNodeDebug_InstrumentFunction::visit ( SimVisitor & vis ) {
         V_BEGIN();
         V_OP(Instrument);
@@ -17,6 +17,9 @@ static bool pauseAfterErrors = false;
 static bool quiet = false;
 static bool paranoid_validation = false;
 static bool jitEnabled = false;
+static string aotProfileFile;
+static double aotProfileCoverage = 0.95;
+static int aotProfileInlineSize = 32;
 
 das::Context * get_context ( int stackSize=0 );
 
@@ -139,6 +142,18 @@ bool compile ( const string & fn, const string & cppFn, bool dryRun ) {
                 tw << "#pragma clang diagnostic ignored \"-Wunused-function\"\n";
                 tw << "#endif\n";
                 tw << "\n";
+                if ( !aotProfileFile.empty() ) {
+                    AotProfile profile;
+                    if ( !loadAotProfile(aotProfileFile, profile, tout) ) {
+                        return false;
+                    }
+                    TextWriter report;
+                    program->markHotAot(profile, aotProfileCoverage, aotProfileInlineSize, report);
+                    if ( !quiet ) {
+                        tout << report.str();
+                    }
+                    tw << report.str() << "\n";
+                }
                 tw << "namespace das {\n";
 
                 tw << "namespace " << program->thisNamespace << " {\n"; // anonymous
@@ -216,6 +231,7 @@ int das_aot_main ( int argc, char * argv[] ) {
     #endif
     if ( argc<=3 ) {
         tout << "daScript -aot <in_script.das> <out_script.das.cpp> [-standalone-context <ctx_name>] [-q] [-j] [-dry-run]\n";
+        tout << "    [-aot-profile <profile.txt>] [-aot-coverage <fraction>] [-aot-inline-size <expressions>]\n";
         return -1;
     }
     bool dryRun = false;
@@ -230,6 +246,27 @@ int das_aot_main ( int argc, char * argv[] ) {
                 paranoid_validation = true;
             } else if ( strcmp(argv[ai],"-dry-run")==0 ) {
                 dryRun = true;
+            } else if ( strcmp(argv[ai],"-aot-profile")==0 ) {
+                if ( ai+1 >= argc ) {
+                    tout << "aot-profile requires argument";
+                    return -1;
+                }
+                aotProfileFile = argv[ai+1];
+                ai += 1;
+            } else if ( strcmp(argv[ai],"-aot-coverage")==0 ) {
+                if ( ai+1 >= argc ) {
+                    tout << "aot-coverage requires argument";
+                    return -1;
+                }
+                aotProfileCoverage = atof(argv[ai+1]);
+                ai += 1;
+            } else if ( strcmp(argv[ai],"-aot-inline-size")==0 ) {
+                if ( ai+1 >= argc ) {
+                    tout << "aot-inline-size requires argument";
+                    return -1;
+                }
+                aotProfileInlineSize = atoi(argv[ai+1]);
+                ai += 1;
             } else if ( strcmp(argv[ai],"-standalone-context")==0 ) {
                 standaloneContextName = argv[ai + 1];
                 standaloneContext = true;
@@ -378,7 +415,7 @@ bool compile_and_run ( const string & fn, const string & mainFnName, bool output
                         pctx->evalWithCatch(fnTest, nullptr);
                     }
                     if ( auto ex = pctx->getException() ) {
-                        tout << "EXCEPTION: " << ex << " at " << pctx->exceptionAt.describe() << "\n";
+                        tout << "EXCEPTION: " << ex << " at " << pctx->exceptionAt.describe() << pctx->exceptionAt.describeInlined() << "\n";
                         success = false;
                     }
                 }
@@ -409,6 +446,9 @@ void print_help() {
         << "    -q          suppress all output\n"
         << "    -dry-run    no changes will be written\n"
         << "    -dasroot    set path to dascript root folder (with daslib)\n"
+        << "    -aot-profile <profile.txt> only compile hot functions from the profile, rest is interpreted\n"
+        << "    -aot-coverage <fraction> fraction of the profiled time hot functions should cover, default 0.95\n"
+        << "    -aot-inline-size <n> small callees of hot functions (up to n expressions) are compiled too, default 32\n"
     ;
 }
 
@@ -509,6 +549,14 @@ int MAIN_FUNC_NAME ( int argc, char * argv[] ) {
                     return -1;
                 }
                 i += 1;
+            } else if ( cmd=="-das-profiler-aot-profile") {
+                // script will pick up next argument by itself
+                if ( i+1 > argc ) {
+                    printf("expecting AOT profile file name\n");
+                    print_help();
+                    return -1;
+                }
+                i += 1;
             } else if ( cmd=="-das-profiler-manual" ) {
                 // do nohting, script handles it
             } else if ( cmd=="-das-profiler-memory" ) {